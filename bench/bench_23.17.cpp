@@ -0,0 +1,702 @@
+#include "aoc23.17.h"
+#include "aoc23.17.alt.h"
+#include "aoc23.17.anytime.h"
+#include "aoc23.17.batch.h"
+#include "aoc23.17.ch.h"
+#include "aoc23.17.cost_to_go.h"
+#include "aoc23.17.generate.h"
+#include "aoc23.17.incremental.h"
+#include "aoc23.17.jump.h"
+#include "aoc23.17.overlay.h"
+#include "aoc23.17.packed.h"
+#include "aoc23.17.pyramid.h"
+#include "aoc23.17.relax.h"
+#include "aoc23.17.sweep.h"
+#include "aoc23.17.tiled.h"
+#include "aoc23.17.wavefront.h"
+
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <queue>
+#include <random>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+template<typename F>
+auto measure(F &&f) {
+    const auto start_time = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+}
+
+// Instructions retired in user space while running f, if the kernel lets us count them
+template<typename F>
+std::optional<std::uint64_t> count_instructions(F &&f) {
+#ifdef __linux__
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    const auto fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd >= 0) {
+        ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        f();
+        ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        std::uint64_t count = 0;
+        const auto read_ok = ::read(fd, &count, sizeof(count)) == sizeof(count);
+        ::close(fd);
+        if (read_ok) return count;
+        return std::nullopt;
+    }
+#endif
+    f();
+    return std::nullopt;
+}
+
+void bench_cost_to_go() {
+    constexpr std::size_t size = 300;
+    const auto map = random_city_map(size, size);
+    const auto depot = heat_loss_query::whole_map(map).target;
+
+    std::optional<cost_to_go_table> table;
+    const auto compute_elapsed = measure([&] { table = cost_to_go_table::compute(map, depot); });
+    std::cout << std::format("cost to go {}x{}: table {:8}us\n", size, size, compute_elapsed.count());
+
+    std::mt19937 engine{42};
+    std::uniform_int_distribution<std::size_t> coordinate{0, size - 1};
+    std::vector<heat_loss_query> queries;
+    for (int i = 0; i < 1000; ++i) {
+        queries.push_back({.source = {coordinate(engine), coordinate(engine)}, .target = depot});
+    }
+    unsigned sum = 0;
+    const auto lookup_elapsed = measure([&] {
+        for (const auto &query : queries) sum += minimal_heat_loss(*table, map, query);
+    });
+    std::cout << std::format("cost to go {}x{}: {} lookups {:8}us, checksum {}\n", size, size, queries.size(),
+                             lookup_elapsed.count(), sum);
+
+    const heat_loss_query nearby{.source = {10, 20}, .target = {size - 20, size - 10}};
+    unsigned guided_result = 0;
+    unsigned plain_result = 0;
+    const auto guided = measure([&] { guided_result = minimal_heat_loss(*table, map, nearby); });
+    const auto plain = measure([&] { plain_result = minimal_heat_loss(map, nearby); });
+    std::cout << std::format("cost to go {}x{}: nearby target with table {:8}us, dijkstra {:8}us, results {} {}\n",
+                             size, size, guided.count(), plain.count(), guided_result, plain_result);
+}
+
+void bench_dijkstra() {
+    for (std::size_t size : {141, 300}) {
+        const auto map = random_city_map(size, size);
+        unsigned result = 0;
+        const auto elapsed = measure([&] { result = minimal_heat_loss(map); });
+        std::cout << std::format("dijkstra {}x{}: {:8}us, result {}\n", size, size, elapsed.count(), result);
+    }
+}
+
+void bench_alt() {
+    constexpr std::size_t size = 300;
+    constexpr int query_count = 20;
+    const auto map = random_city_map(size, size);
+
+    std::mt19937 engine{42};
+    std::uniform_int_distribution<std::size_t> coordinate{0, size - 1};
+    std::vector<heat_loss_query> queries;
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back({.source = {coordinate(engine), coordinate(engine)},
+                           .target = {coordinate(engine), coordinate(engine)}});
+    }
+
+    std::chrono::microseconds blind_elapsed{0};
+    for (const std::size_t landmark_count : {0, 4, 8, 16}) {
+        std::optional<alt_landmarks> landmarks;
+        const auto preprocessing = measure([&] { landmarks = alt_landmarks::compute(map, landmark_count); });
+        std::size_t expanded = 0;
+        unsigned sum = 0;
+        const auto elapsed = measure([&] {
+            for (const auto &query : queries) {
+                const auto result = alt_search(*landmarks, query);
+                expanded += result.expanded_nodes;
+                sum += result.heat_loss;
+            }
+        });
+        if (landmark_count == 0) blind_elapsed = elapsed;
+        std::cout << std::format("alt {}x{}, {:2} landmarks: preprocessing {:8}us, {:6}kB, {} queries {:8}us, "
+                                 "speedup {:5.1f}, {:8} expanded per query, checksum {}\n",
+                                 size, size, landmark_count, preprocessing.count(), landmarks->memory_bytes() / 1024,
+                                 query_count, elapsed.count(), double(blind_elapsed.count()) / double(elapsed.count()),
+                                 expanded / query_count, sum);
+    }
+}
+
+void bench_batch() {
+    constexpr std::size_t count = 64;
+    std::vector<city_map> maps;
+    for (std::size_t i = 0; i < count; ++i) {
+        maps.push_back(random_city_map(141, 141, static_cast<unsigned>(i + 1)));
+    }
+    const auto query = heat_loss_query::whole_map(maps.front());
+    const auto per_map = [&](auto solve) {
+        unsigned sum = 0;
+        const auto elapsed = measure([&] {
+            for (const auto &map : maps) sum += solve(map);
+        });
+        return std::tuple{elapsed, sum};
+    };
+    const auto [dijkstra_elapsed, dijkstra_sum] = per_map([](const city_map &map) { return minimal_heat_loss(map); });
+    const auto [jump_elapsed, jump_sum] = per_map([&](const city_map &map) {
+        return minimal_heat_loss_jump(map, query);
+    });
+    const auto [sweep_elapsed, sweep_sum] = per_map([&](const city_map &map) {
+        return minimal_heat_loss_sweep(map, query);
+    });
+    std::cout << std::format("batch {} maps 141x141 one by one: dijkstra {:8}us, jump {:8}us, sweep {:8}us, "
+                             "sums {} {} {}\n",
+                             count, dijkstra_elapsed.count(), jump_elapsed.count(), sweep_elapsed.count(),
+                             dijkstra_sum, jump_sum, sweep_sum);
+
+    const std::vector<city_map_view> views(maps.begin(), maps.end());
+    const auto batched = [&]<typename Batch>(const char *name, relax_kernel kernel) {
+        unsigned sum = 0;
+        std::size_t sweeps = 0;
+        const auto elapsed = measure([&] {
+            for (std::size_t first = 0; first < count; first += Batch::lanes) {
+                Batch batch{std::span(views).subspan(first, Batch::lanes), query.source, kernel};
+                batch.run();
+                sweeps += batch.sweeps;
+                for (std::size_t i = 0; i < batch.size(); ++i) sum += batch.get_minimal_heat_loss(i);
+            }
+        });
+        std::cout << std::format("batch {} maps 141x141 {:2} at a time, {:6}: {:8}us, {:4} passes per batch, "
+                                 "sum {}\n",
+                                 count, Batch::lanes, name, elapsed.count(), sweeps * Batch::lanes / count, sum);
+    };
+    batched.template operator()<heat_loss_batch>("scalar", relax_kernel::scalar);
+    batched.template operator()<heat_loss_batch16>("scalar", relax_kernel::scalar);
+    if (avx2_available()) {
+        batched.template operator()<heat_loss_batch>("avx2", relax_kernel::avx2);
+        batched.template operator()<heat_loss_batch16>("avx2", relax_kernel::avx2);
+    }
+}
+
+void bench_ch() {
+    constexpr int query_count = 100;
+    for (const std::size_t size : {30, 60, 141}) {
+        const auto map = random_city_map(size, size);
+        std::mt19937 engine{42};
+        std::uniform_int_distribution<std::size_t> coordinate{0, size - 1};
+        std::vector<heat_loss_query> queries;
+        for (int i = 0; i < query_count; ++i) {
+            queries.push_back({.source = {coordinate(engine), coordinate(engine)},
+                               .target = {coordinate(engine), coordinate(engine)}});
+        }
+
+        const auto blind = alt_landmarks::compute(map, 0);
+        unsigned blind_sum = 0;
+        const auto blind_elapsed = measure([&] {
+            for (const auto &query : queries) blind_sum += minimal_heat_loss(blind, query);
+        });
+
+        std::optional<contraction_hierarchy> hierarchy;
+        const auto preprocessing = measure([&] { hierarchy = contraction_hierarchy::compute(map); });
+        contraction_hierarchy_query ch_query{*hierarchy};
+        std::size_t settled = 0;
+        unsigned sum = 0;
+        const auto elapsed = measure([&] {
+            for (const auto &query : queries) {
+                sum += ch_query.run(query);
+                settled += ch_query.settled_nodes;
+            }
+        });
+        std::cout << std::format("ch {}x{}: preprocessing {:9}us, {:8} edges for {:6} states, {} queries {:7}us "
+                                 "against {:8}us, speedup {:6.1f}, {:6} settled per query, checksum {} {}\n",
+                                 size, size, preprocessing.count(), hierarchy->edge_count(), hierarchy->node_count(),
+                                 query_count, elapsed.count(), blind_elapsed.count(),
+                                 double(blind_elapsed.count()) / double(elapsed.count()), settled / query_count, sum,
+                                 blind_sum);
+    }
+}
+
+void bench_anytime() {
+    for (std::size_t size : {141, 300}) {
+        const auto map = random_city_map(size, size);
+        const auto query = heat_loss_query::whole_map(map);
+        for (const auto budget : {std::chrono::milliseconds{1}, std::chrono::milliseconds{10},
+                                  std::chrono::milliseconds{100}, std::chrono::milliseconds{1000}}) {
+            anytime_result result;
+            const auto elapsed = measure([&] {
+                result = minimal_heat_loss_anytime(map, query, {.deadline = std::chrono::steady_clock::now() + budget});
+            });
+            std::cout << std::format("anytime {}x{}, budget {:5}: {:8}us, upper bound {:10}, lower bound {}\n",
+                                     size, size, budget, elapsed.count(), result.upper_bound, result.lower_bound);
+        }
+    }
+}
+
+void bench_incremental() {
+    constexpr std::size_t size = 300;
+    constexpr unsigned rounds = 10;
+
+    heat_loss_algorithm_incremental algorithm{random_city_map(size, size)};
+    std::mt19937 engine{42};
+    std::uniform_int_distribution<std::size_t> coordinate{0, size-1};
+    std::uniform_int_distribution<unsigned> digit{1, 9};
+
+    for (unsigned batch_size : {1, 4, 16, 64}) {
+        std::chrono::microseconds incremental{0};
+        std::chrono::microseconds full{0};
+        std::size_t repaired = 0;
+
+        for (unsigned round = 0; round < rounds; ++round) {
+            for (unsigned i = 0; i < batch_size; ++i) {
+                algorithm.set_heat_loss({coordinate(engine), coordinate(engine)}, digit(engine));
+            }
+            unsigned incremental_result = 0;
+            incremental += measure([&] { incremental_result = algorithm.get_minimal_heat_loss(); });
+            repaired += algorithm.repaired_nodes;
+
+            unsigned full_result = 0;
+            full += measure([&] { algorithm.solve(); full_result = algorithm.get_minimal_heat_loss(); });
+            if (full_result != incremental_result) {
+                throw std::runtime_error(std::format("incremental result {} differs from full solve {}",
+                                                     incremental_result, full_result));
+            }
+        }
+        std::cout << std::format("incremental {}x{}, {:2} updates: repair {:8}us, full solve {:8}us, "
+                                 "speedup {:6.1f}, repaired nodes {}\n",
+                                 size, size, batch_size, incremental.count() / rounds, full.count() / rounds,
+                                 double(full.count()) / double(incremental.count()), repaired / rounds);
+    }
+}
+
+// Plain binary heap Dijkstra over the state graph, so that the time is dominated by the state tables and not by the
+// sorted vector queue of heat_loss_algorithm_dijkstra
+template<typename Layout>
+unsigned heap_dijkstra(city_map_view map) {
+    using graph_type = basic_heat_loss_state_graph<Layout>;
+    using node = typename graph_type::node;
+    const graph_type graph{map};
+    lazy_heat_loss_table heat_loss(graph.size());
+    zeroed_buffer<bool> visited(graph.size());
+    std::priority_queue<std::pair<unsigned, std::size_t>, std::vector<std::pair<unsigned, std::size_t>>,
+                        std::greater<>> queue;
+
+    const auto start = graph.to_index(graph_type::start_node(heat_loss_algorithm::initial_position));
+    heat_loss.set(start, 0);
+    queue.emplace(0, start);
+    const city_map::position target{map.width() - 1, map.height() - 1};
+    while (!queue.empty()) {
+        const auto [current_heat_loss, current_index] = queue.top();
+        queue.pop();
+        if (visited[current_index]) continue;
+        visited[current_index] = true;
+
+        const auto current = graph.to_node(current_index);
+        if (current.pos == target) {
+            return current_heat_loss;
+        }
+        graph.for_each_successor(current, [&](const node &next) {
+            const auto next_index = graph.to_index(next);
+            const auto tentative_heat_loss = current_heat_loss + map.heat_loss(next.pos);
+            if (tentative_heat_loss < heat_loss.get(next_index)) {
+                heat_loss.set(next_index, tentative_heat_loss);
+                queue.emplace(tentative_heat_loss, next_index);
+            }
+        });
+    }
+    return heat_loss_algorithm::maximal_heat_loss;
+}
+
+void bench_overlay() {
+    constexpr int query_count = 20;
+    for (const std::size_t size : {141, 300}) {
+        const auto map = random_city_map(size, size);
+        std::mt19937 engine{42};
+        std::uniform_int_distribution<std::size_t> coordinate{0, size - 1};
+        std::vector<heat_loss_query> queries;
+        for (int i = 0; i < query_count; ++i) {
+            queries.push_back({.source = {coordinate(engine), coordinate(engine)},
+                               .target = {coordinate(engine), coordinate(engine)}});
+        }
+
+        const auto blind = alt_landmarks::compute(map, 0);
+        unsigned blind_sum = 0;
+        const auto blind_elapsed = measure([&] {
+            for (const auto &query : queries) blind_sum += minimal_heat_loss(blind, query);
+        });
+        std::cout << std::format("overlay {}x{}: {} queries without overlay {:8}us, checksum {}\n",
+                                 size, size, query_count, blind_elapsed.count(), blind_sum);
+
+        for (const std::size_t tile_size : {8, 16, 32}) {
+            std::optional<tile_overlay> overlay;
+            const auto preprocessing = measure([&] { overlay.emplace(map, tile_size); });
+            std::size_t settled = 0;
+            unsigned sum = 0;
+            const auto elapsed = measure([&] {
+                for (const auto &query : queries) {
+                    sum += overlay->minimal_heat_loss(query);
+                    settled += overlay->settled_entries;
+                }
+            });
+            // patch one cell and answer a query, which recomputes one clique, against solving the patched map
+            const city_map::position patched{size / 2, size / 2};
+            auto changed = map;
+            changed.set_heat_loss(patched, map.heat_loss(patched) % 9 + 1);
+            unsigned patched_result = 0;
+            const auto patch = measure([&] {
+                overlay->set_heat_loss(patched, changed.heat_loss(patched));
+                patched_result = overlay->minimal_heat_loss(queries[0]);
+            });
+            unsigned resolved = 0;
+            const auto resolve = measure([&] {
+                resolved = minimal_heat_loss(alt_landmarks::compute(changed, 0), queries[0]);
+            });
+            std::cout << std::format("overlay {}x{}, tiles {:2}: preprocessing {:8}us, {:8} edges, queries {:8}us, "
+                                     "speedup {:5.1f}, {:6} settled per query, patch and query {:6}us against "
+                                     "{:6}us, checksum {}, results {} {}\n",
+                                     size, size, tile_size, preprocessing.count(), overlay->edge_count(),
+                                     elapsed.count(), double(blind_elapsed.count()) / double(elapsed.count()),
+                                     settled / query_count, patch.count(), resolve.count(), sum, patched_result,
+                                     resolved);
+        }
+    }
+}
+
+void bench_packed() {
+    for (const std::size_t size : {1000, 4000, 8000}) {
+        const auto map = random_city_map(size, size);
+        const city_map_view view{map};
+        const packed_city_map packed{map};
+        const auto cells = double(size * size);
+
+        // row by row passes like the sweep engines make, reading each row once: a streaming one that only adds the
+        // row to a running total per column, and one with the cheapest way down or right, which carries a dependency
+        // along the row
+        const auto pass = [&](bool along_row, auto &&row_weights) {
+            std::vector<unsigned> costs(size, 0);
+            std::vector<unsigned> buffer(size);
+            for (std::size_t y = 0; y < size; ++y) {
+                const unsigned *w = row_weights(y, buffer.data());
+                if (along_row) {
+                    costs[0] += w[0];
+                    for (std::size_t x = 1; x < size; ++x) costs[x] = std::min(costs[x], costs[x - 1]) + w[x];
+                } else {
+                    for (std::size_t x = 0; x < size; ++x) costs[x] += w[x];
+                }
+            }
+            return costs.back();
+        };
+        const auto direct_row = [&](std::size_t y, unsigned *) { return view.row_data(y); };
+        const auto unpacked_row = [&](relax_kernel kernel) {
+            return [&packed, kernel](std::size_t y, unsigned *buffer) {
+                packed.unpack_row(y, buffer, kernel);
+                return static_cast<const unsigned *>(buffer);
+            };
+        };
+        const auto per_cell = [&](std::chrono::microseconds elapsed) { return double(elapsed.count()) * 1e3 / cells; };
+        for (const bool along_row : {false, true}) {
+            unsigned results[3]{};
+            const auto direct = measure([&] { results[0] = pass(along_row, direct_row); });
+            const auto scalar = measure([&] { results[1] = pass(along_row, unpacked_row(relax_kernel::scalar)); });
+            const auto avx2 = measure([&] { results[2] = pass(along_row, unpacked_row(best_relax_kernel())); });
+            std::cout << std::format("packed {:4}x{:4}, {:9} pass: direct {:5.2f}ns, scalar unpack {:5.2f}ns, "
+                                     "avx2 unpack {:5.2f}ns per cell, results {} {} {}\n",
+                                     size, size, along_row ? "dependent" : "streaming", per_cell(direct),
+                                     per_cell(scalar), per_cell(avx2), results[0], results[1], results[2]);
+        }
+
+        // scattered single cells, as a queue based search reads them
+        constexpr std::size_t reads = 1 << 22;
+        std::mt19937 engine{42};
+        std::uniform_int_distribution<std::size_t> coordinate{0, size - 1};
+        std::vector<city_map::position> positions(reads);
+        for (auto &pos : positions) pos = {coordinate(engine), coordinate(engine)};
+        unsigned sums[2]{};
+        const auto random_direct = measure([&] {
+            for (const auto &pos : positions) sums[0] += view.heat_loss(pos);
+        });
+        const auto random_packed = measure([&] {
+            for (const auto &pos : positions) sums[1] += packed.heat_loss(pos);
+        });
+
+        std::cout << std::format("packed {:4}x{:4}: {:9} bytes instead of {:10}, random reads direct {:5.2f}ns, "
+                                 "packed {:5.2f}ns, checksums {} {}\n",
+                                 size, size, packed.memory_bytes(), size * size * sizeof(unsigned),
+                                 double(random_direct.count()) * 1e3 / reads,
+                                 double(random_packed.count()) * 1e3 / reads, sums[0], sums[1]);
+    }
+}
+
+void bench_pyramid() {
+    for (const bool lakes : {false, true}) {
+        for (const std::size_t size : {141, 300}) {
+            auto map = random_city_map(size, size);
+            if (lakes) {
+                // expensive squares of an eighth of the map side
+                std::mt19937 engine{3};
+                std::uniform_int_distribution<std::size_t> coordinate{0, size - 1};
+                for (std::size_t lake = 0; lake < size / 10; ++lake) {
+                    const auto x0 = coordinate(engine);
+                    const auto y0 = coordinate(engine);
+                    for (auto y = y0; y < std::min(size, y0 + size / 8); ++y) {
+                        for (auto x = x0; x < std::min(size, x0 + size / 8); ++x) map.set_heat_loss({x, y}, 9);
+                    }
+                }
+            }
+            const auto name = std::format("{} {}x{}", lakes ? "lakes" : "random", size, size);
+            const auto query = heat_loss_query::whole_map(map);
+
+            alt_search_result blind;
+            const auto blind_elapsed = measure([&] { blind = alt_search(alt_landmarks::compute(map, 0), query); });
+            std::cout << std::format("pyramid {:14}: without heuristic {:8}us, {:8} expanded, result {}\n",
+                                     name, blind_elapsed.count(), blind.expanded_nodes, blind.heat_loss);
+
+            std::optional<cost_pyramid> pyramid;
+            const auto build = measure([&] { pyramid.emplace(map); });
+            for (std::size_t level = 0; level < 4; ++level) {
+                std::optional<heat_loss_algorithm_pyramid> guided;
+                unsigned result = 0;
+                const auto elapsed = measure([&] {
+                    guided.emplace(*pyramid, query, level);
+                    result = guided->run();
+                });
+                std::cout << std::format("pyramid {:14}, level {}: build {:6}us, heuristic {:6}us, total {:8}us, "
+                                         "{:8} expanded, ratio {:5.3f}, estimate {:4}, result {}\n",
+                                         name, level, build.count(),
+                                         std::chrono::duration_cast<std::chrono::microseconds>(
+                                                 guided->h.build_time).count(),
+                                         elapsed.count(), guided->expanded_nodes,
+                                         double(guided->expanded_nodes) / double(blind.expanded_nodes),
+                                         guided->h(query.source), result);
+            }
+        }
+    }
+}
+
+void bench_jump() {
+    for (const bool serpentine : {false, true}) {
+        for (const std::size_t size : {141, 300, 1000}) {
+            const auto map = serpentine ? serpentine_city_map(size, size) : random_city_map(size, size);
+            const auto name = std::format("{} {}x{}", serpentine ? "serpentine" : "random", size, size);
+            const auto query = heat_loss_query::whole_map(map);
+
+            alt_search_result blind;
+            const auto blind_elapsed = measure([&] { blind = alt_search(alt_landmarks::compute(map, 0), query); });
+            unsigned heap_result = 0;
+            const auto heap_elapsed = measure([&] { heap_result = heap_dijkstra<state_layout>(map); });
+            std::optional<heat_loss_algorithm_jump> jump;
+            unsigned result = 0;
+            const auto elapsed = measure([&] {
+                jump.emplace(map, query);
+                result = jump->run();
+            });
+            std::cout << std::format("jump {:20}: state graph {:8}us, {:8} expanded, heap {:8}us, jump {:8}us, "
+                                     "{:8} expanded, {:8} pushed, results {} {} {}\n",
+                                     name, blind_elapsed.count(), blind.expanded_nodes, heap_elapsed.count(),
+                                     elapsed.count(), jump->expanded_nodes, jump->pushed_nodes, blind.heat_loss,
+                                     heap_result, result);
+        }
+    }
+}
+
+void bench_layout() {
+    for (std::size_t size : {1000, 2000}) {
+        const auto map = random_city_map(size, size);
+        const auto run = [&]<typename Layout>(const char *name, Layout) {
+            unsigned result = 0;
+            const auto elapsed = measure([&] { result = heap_dijkstra<Layout>(map); });
+            std::cout << std::format("layout {}x{}, {:13}: {:9}us, result {}\n", size, size, name, elapsed.count(),
+                                     result);
+        };
+        run("row major", row_major_state_layout{});
+        run("8x8 tiles", tiled_state_layout<8>{});
+        run("32x32 tiles", tiled_state_layout<32>{});
+    }
+}
+
+void bench_relax() {
+    constexpr unsigned passes = 10;
+    for (std::size_t size : {300, 1000}) {
+        const auto map = random_city_map(size, size);
+        for (const auto kernel : {relax_kernel::scalar, relax_kernel::avx2}) {
+            if (kernel == relax_kernel::avx2 && !avx2_available()) continue;
+
+            state_planes planes{map};
+            planes.set(heat_loss_state_graph::start_node(heat_loss_algorithm::initial_position), 0);
+            std::optional<std::uint64_t> instructions;
+            const auto elapsed = measure([&] {
+                instructions = count_instructions([&] {
+                    for (unsigned pass = 0; pass < passes; ++pass) relax_pass(planes, kernel);
+                });
+            });
+            const auto cell_passes = static_cast<double>(size * size * passes);
+            std::cout << std::format("relax {}x{}, {:6}: {:8}us for {} passes, {:6.2f}ns and {} instructions/cell\n",
+                                     size, size, kernel == relax_kernel::avx2 ? "avx2" : "scalar", elapsed.count(),
+                                     passes, 1000.0 * double(elapsed.count()) / cell_passes,
+                                     instructions ? std::format("{:.1f}", double(*instructions) / cell_passes)
+                                                  : std::string{"n/a"});
+        }
+    }
+}
+
+void bench_segments() {
+    for (const std::size_t size : {141, 1000, 8000}) {
+        auto map = random_city_map(size, size);
+        constexpr std::size_t lookups = 1 << 20;
+        std::mt19937 engine{42};
+        std::uniform_int_distribution<std::size_t> coordinate{0, size - 1};
+        std::uniform_int_distribution<int> direction_index{0, 3};
+        std::vector<std::pair<city_map::position, direction>> starts(lookups);
+        for (auto &[pos, dir] : starts) {
+            pos = {coordinate(engine), coordinate(engine)};
+            dir = static_cast<direction>(direction_index(engine));
+        }
+
+        // the longest segment of at most `length` cells from each start
+        const auto run = [&](std::size_t length) {
+            unsigned sum = 0;
+            for (const auto &[pos, dir] : starts) {
+                const auto room = dir == direction::NORTH ? pos.y : dir == direction::SOUTH ? size - 1 - pos.y
+                                : dir == direction::WEST ? pos.x : size - 1 - pos.x;
+                sum += map.segment_cost(pos, dir, std::min(length, room));
+            }
+            return sum;
+        };
+        for (const std::size_t length : {3, 10, 100}) {
+            map = random_city_map(size, size);
+            unsigned sums[2]{};
+            const auto cell_by_cell = measure([&] { sums[0] = run(length); });
+            const auto build = measure([&] { map.build_prefix_sums(); });
+            const auto prefix = measure([&] { sums[1] = run(length); });
+            std::cout << std::format("segments {:4}x{:4}, up to {:3} cells: cell by cell {:6.1f}ns, prefix sums "
+                                     "{:6.1f}ns per segment, built in {:7}us into {:9} bytes, checksums {} {}\n",
+                                     size, size, length, double(cell_by_cell.count()) * 1e3 / lookups,
+                                     double(prefix.count()) * 1e3 / lookups, build.count(), map.prefix_sum_bytes(),
+                                     sums[0], sums[1]);
+        }
+    }
+}
+
+void bench_sweep() {
+    for (const bool serpentine : {false, true}) {
+        for (std::size_t size : {141, 300}) {
+            const auto map = serpentine ? serpentine_city_map(size, size) : random_city_map(size, size);
+            const auto name = std::format("{} {}x{}", serpentine ? "serpentine" : "random", size, size);
+
+            unsigned queue_result = 0;
+            const auto queue_elapsed = measure([&] { queue_result = minimal_heat_loss(map); });
+            unsigned heap_result = 0;
+            const auto heap_elapsed = measure([&] { heap_result = heap_dijkstra<state_layout>(map); });
+            heat_loss_algorithm_sweep sweep{map};
+            const auto sweep_elapsed = measure([&] { sweep.run(); });
+            std::cout << std::format("sweep {:18}: dijkstra {:8}us, heap {:8}us, sweep {:8}us in {:4} passes, "
+                                     "results {} {} {}\n",
+                                     name, queue_elapsed.count(), heap_elapsed.count(), sweep_elapsed.count(),
+                                     sweep.sweeps, queue_result, heap_result, sweep.get_minimal_heat_loss());
+        }
+    }
+}
+
+void bench_wavefront() {
+    for (const bool serpentine : {false, true}) {
+        for (const std::size_t size : {141, 300, 1000}) {
+            const auto map = serpentine ? serpentine_city_map(size, size) : random_city_map(size, size);
+            const auto name = std::format("{} {}x{}", serpentine ? "serpentine" : "random", size, size);
+            const auto query = heat_loss_query::whole_map(map);
+
+            unsigned jump_result = 0;
+            const auto jump_elapsed = measure([&] { jump_result = minimal_heat_loss_jump(map, query); });
+            heat_loss_algorithm_sweep sweep{map};
+            const auto sweep_elapsed = measure([&] { sweep.run(); });
+            std::cout << std::format("wavefront {:20}: jump {:8}us, row sweep {:8}us in {:4} passes, results {} {}\n",
+                                     name, jump_elapsed.count(), sweep_elapsed.count(), sweep.sweeps, jump_result,
+                                     sweep.get_minimal_heat_loss());
+            for (const unsigned threads : {1, 2, 4, 8}) {
+                heat_loss_algorithm_wavefront wavefront{map, heat_loss_algorithm::initial_position, threads};
+                const auto elapsed = measure([&] { wavefront.run(); });
+                std::cout << std::format("wavefront {:20}, {} threads: {:8}us in {:4} passes, result {}\n",
+                                         name, threads, elapsed.count(), wavefront.sweeps,
+                                         wavefront.get_minimal_heat_loss());
+            }
+        }
+    }
+}
+
+void bench_tiled() {
+    const auto base = random_city_map(141, 141);
+    for (const std::size_t tiles : {2, 5, 10}) {
+        const tiled_city_map tiled{base, tiles, tiles};
+        const auto query = heat_loss_query::whole_map(tiled);
+        unsigned tiled_result = 0;
+        const auto tiled_elapsed = measure([&] { tiled_result = minimal_heat_loss(tiled, query); });
+        std::optional<city_map> materialized;
+        const auto materialize_elapsed = measure([&] { materialized.emplace(to_city_map(tiled)); });
+        unsigned materialized_result = 0;
+        const auto materialized_elapsed = measure([&] {
+            materialized_result = minimal_heat_loss_jump(*materialized, query);
+        });
+        std::cout << std::format("tiled {:2}x{:2} of 141x141: on the fly {:8}us, materializing {:7}us and {:9} bytes, "
+                                 "then {:8}us, results {} {}\n",
+                                 tiles, tiles, tiled_elapsed.count(), materialize_elapsed.count(),
+                                 tiled.width() * tiled.height() * sizeof(unsigned), materialized_elapsed.count(),
+                                 tiled_result, materialized_result);
+    }
+}
+
+const std::map<std::string, std::function<void()>> benchmarks{
+        {"alt", bench_alt},
+        {"anytime", bench_anytime},
+        {"batch", bench_batch},
+        {"ch", bench_ch},
+        {"cost_to_go", bench_cost_to_go},
+        {"dijkstra", bench_dijkstra},
+        {"incremental", bench_incremental},
+        {"jump", bench_jump},
+        {"layout", bench_layout},
+        {"overlay", bench_overlay},
+        {"packed", bench_packed},
+        {"pyramid", bench_pyramid},
+        {"relax", bench_relax},
+        {"segments", bench_segments},
+        {"sweep", bench_sweep},
+        {"tiled", bench_tiled},
+        {"wavefront", bench_wavefront},
+};
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        for (const auto &[name, benchmark] : benchmarks) {
+            benchmark();
+        }
+        return 0;
+    }
+    for (int i = 1; i < argc; ++i) {
+        const auto it = benchmarks.find(argv[i]);
+        if (it == benchmarks.end()) {
+            std::cerr << std::format("unknown benchmark: {}\n", argv[i]);
+            return 1;
+        }
+        it->second();
+    }
+}
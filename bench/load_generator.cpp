@@ -0,0 +1,114 @@
+#include "aoc23.17.h"
+#include "aoc23.17.generate.h"
+#include "aoc23.17.server.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Sends random maps to a running "aoc_23 --serve" with a fixed number of requests in flight and reports the
+// throughput and latency distribution.
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: aoc_23_load <socket> [requests=1000] [in flight=16] [size=141] [text|binary]\n";
+        return 1;
+    }
+    const std::string socket_path = argv[1];
+    const std::size_t requests = argc > 2 ? std::stoul(argv[2]) : 1000;
+    const std::size_t in_flight = argc > 3 ? std::max(1ul, std::stoul(argv[3])) : 16;
+    const std::size_t size = argc > 4 ? std::stoul(argv[4]) : 141;
+    const auto format = argc > 5 && std::string_view{argv[5]} == "text"
+                        ? solver_protocol::map_format::text : solver_protocol::map_format::binary;
+
+    using clock = std::chrono::steady_clock;
+    constexpr unsigned distinct_maps = 8;
+    std::vector<city_map> maps;
+    for (unsigned seed = 0; seed < distinct_maps; ++seed) {
+        maps.push_back(random_city_map(size, size, seed));
+    }
+
+    const int fd = solver_protocol::connect_to(socket_path);
+    std::vector<clock::time_point> sent(requests);
+    std::vector<clock::duration> latencies(requests);
+
+    std::mutex mutex;
+    std::condition_variable slot_free;
+    std::size_t outstanding = 0;
+    std::size_t failures = 0;
+    // set by either thread when the connection broke, wakes the other one
+    bool broken = false;
+    const auto fail = [&](std::string_view reason) {
+        std::lock_guard lock{mutex};
+        if (!broken) {
+            std::cerr << reason << '\n';
+            broken = true;
+        }
+        // the receiver may be waiting for a response
+        ::shutdown(fd, SHUT_RDWR);
+        slot_free.notify_all();
+    };
+
+    const auto start_time = clock::now();
+    std::thread receiver([&] {
+        for (std::size_t i = 0; i < requests; ++i) {
+            solver_protocol::response_header response;
+            if (!solver_protocol::read_all(fd, &response, sizeof(response))) {
+                fail("connection closed by server");
+                return;
+            }
+            if (response.id >= requests) {
+                fail(std::format("response to unknown request {}", response.id));
+                return;
+            }
+            std::lock_guard lock{mutex};
+            latencies[response.id] = clock::now() - sent[response.id];
+            failures += response.result != solver_protocol::status::ok;
+            --outstanding;
+            slot_free.notify_one();
+        }
+    });
+
+    for (std::size_t i = 0; i < requests; ++i) {
+        const auto &map = maps[i % maps.size()];
+        const auto request = solver_protocol::encode_request(static_cast<std::uint32_t>(i), map,
+                                                             heat_loss_query::whole_map(map), format);
+        {
+            std::unique_lock lock{mutex};
+            slot_free.wait(lock, [&] { return outstanding < in_flight || broken; });
+            if (broken) break;
+            ++outstanding;
+            sent[i] = clock::now();
+        }
+        if (!solver_protocol::write_all(fd, request.data(), request.size())) {
+            fail("could not send request");
+            break;
+        }
+    }
+    receiver.join();
+    const auto elapsed = std::chrono::duration<double>(clock::now() - start_time);
+    ::close(fd);
+    if (broken) {
+        return EXIT_FAILURE;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&](double p) {
+        const auto i = std::min(latencies.size() - 1, static_cast<std::size_t>(p * static_cast<double>(latencies.size())));
+        return std::chrono::duration_cast<std::chrono::microseconds>(latencies[i]).count();
+    };
+    std::cout << std::format("{} requests of {}x{} maps, {} in flight: {:.1f} requests/s, {} failed\n",
+                             requests, size, size, in_flight, static_cast<double>(requests) / elapsed.count(), failures);
+    std::cout << std::format("latency us: p50 {}, p90 {}, p99 {}, p99.9 {}, max {}\n",
+                             percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999), percentile(1.0));
+}
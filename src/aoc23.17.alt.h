@@ -0,0 +1,255 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Preprocessing for arbitrary queries on one static map with A*, landmarks and the triangle inequality (ALT). For
+// each landmark it keeps the heat loss from and to every cell in the relaxed graph without the run length limit,
+// and from and to every state in the real state graph. For any landmark L, d(L, t) - d(L, s) and d(s, L) - d(t, L)
+// are lower bounds for d(s, t); the heuristic takes the largest of them.
+class alt_landmarks {
+public:
+    using position = city_map::position;
+    using node = heat_loss_state_graph::node;
+    // two bytes per value; distances that do not fit are stored as `unknown` and yield no bound
+    using distance = std::uint16_t;
+    static constexpr distance unknown = std::numeric_limits<distance>::max();
+
+    // The four corners first, then each next landmark as far as possible from the chosen ones. The state graph
+    // tables of the landmarks are computed on up to `threads` threads.
+    static alt_landmarks compute(const city_map &map, std::size_t count,
+                                 unsigned threads = std::thread::hardware_concurrency()) {
+        alt_landmarks result{map};
+        result.choose_landmarks(count);
+
+        const auto landmark_count = result.tables.size();
+        const auto workers = std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(landmark_count, 1));
+        {
+            std::vector<std::jthread> pool;
+            for (std::size_t worker = 0; worker < workers; ++worker) {
+                pool.emplace_back([&result, worker, workers, landmark_count] {
+                    for (std::size_t i = worker; i < landmark_count; i += workers) {
+                        auto &table = result.tables[i];
+                        table.states_from = result.state_search(table.landmark, true);
+                        table.states_to = result.state_search(table.landmark, false);
+                    }
+                });
+            }
+        }
+        return result;
+    }
+
+    // the tables only keep a view, so they must not be computed for a temporary map
+    static alt_landmarks compute(city_map &&, std::size_t, unsigned = 0) = delete;
+
+    [[nodiscard]] std::vector<position> landmarks() const {
+        std::vector<position> result;
+        for (const auto &table : tables) result.push_back(table.landmark);
+        return result;
+    }
+
+    [[nodiscard]] std::size_t memory_bytes() const {
+        std::size_t bytes = 0;
+        for (const auto &table : tables) {
+            bytes += (table.cells_from.size() + table.cells_to.size() + table.states_from.size()
+                      + table.states_to.size()) * sizeof(distance);
+        }
+        return bytes;
+    }
+
+    // The bounds that only depend on the target, prepared once per query
+    class heuristic {
+    public:
+        [[nodiscard]] unsigned operator()(const node &n) const {
+            const auto cell = owner->cell_index(n.pos);
+            const auto state = owner->state_index(n);
+            unsigned bound = 0;
+            for (std::size_t i = 0; i < owner->tables.size(); ++i) {
+                const auto &table = owner->tables[i];
+                const auto &at_target = targets[i];
+                bound = std::max({bound, difference(at_target.cell_from, table.cells_from[cell]),
+                                  difference(table.cells_to[cell], at_target.cell_to),
+                                  difference(at_target.state_from, table.states_from[state]),
+                                  difference(table.states_to[state], at_target.state_to)});
+            }
+            return bound;
+        }
+
+    private:
+        friend class alt_landmarks;
+
+        struct target_distances {
+            distance cell_from;
+            distance cell_to;
+            distance state_from; // the nearest state at the target
+            distance state_to;   // the farthest state at the target
+        };
+
+        const alt_landmarks *owner;
+        std::vector<target_distances> targets;
+
+        static unsigned difference(distance a, distance b) {
+            if (a == unknown || b == unknown || a <= b) return 0;
+            return static_cast<unsigned>(a - b);
+        }
+    };
+
+    [[nodiscard]] heuristic heuristic_to(const position &target) const {
+        check_position(map, target);
+        heuristic h;
+        h.owner = this;
+        for (const auto &table : tables) {
+            const auto cell = cell_index(target);
+            distance state_from = unknown;
+            distance state_to = 0;
+            heat_loss_state_graph{map}.for_each_node_at(target, [&](const node &n) {
+                state_from = std::min(state_from, table.states_from[state_index(n)]);
+                state_to = std::max(state_to, table.states_to[state_index(n)]);
+            });
+            h.targets.push_back({table.cells_from[cell], table.cells_to[cell], state_from, state_to});
+        }
+        return h;
+    }
+
+    city_map_view map;
+
+private:
+    struct landmark_tables {
+        position landmark;
+        std::vector<distance> cells_from;
+        std::vector<distance> cells_to;
+        std::vector<distance> states_from;
+        std::vector<distance> states_to;
+    };
+    std::vector<landmark_tables> tables;
+
+    explicit alt_landmarks(city_map_view map)
+            : map(map) {}
+
+    using row_major_graph = basic_heat_loss_state_graph<row_major_state_layout>;
+
+    [[nodiscard]] std::size_t cell_index(const position &pos) const {
+        return pos.y * map.width() + pos.x;
+    }
+
+    [[nodiscard]] std::size_t state_index(const node &n) const {
+        return row_major_graph{map}.to_index(n);
+    }
+
+    static distance narrow(unsigned value) {
+        return value >= unknown ? unknown : static_cast<distance>(value);
+    }
+
+    void choose_landmarks(std::size_t count) {
+        std::vector<position> chosen;
+        for (const auto corner : {position{0, 0}, position{map.width() - 1, map.height() - 1},
+                                  position{map.width() - 1, 0}, position{0, map.height() - 1}}) {
+            if (chosen.size() < count && std::ranges::find(chosen, corner) == chosen.end()) {
+                chosen.push_back(corner);
+            }
+        }
+        for (const auto &landmark : chosen) {
+            add_landmark(landmark);
+        }
+
+        // farthest point selection on the relaxed distances from the landmarks so far
+        std::vector<unsigned> nearest(map.width() * map.height(), heat_loss_algorithm::maximal_heat_loss);
+        const auto update_nearest = [&](const landmark_tables &table) {
+            for (std::size_t i = 0; i < nearest.size(); ++i) {
+                nearest[i] = std::min<unsigned>(nearest[i], table.cells_from[i]);
+            }
+        };
+        for (const auto &table : tables) update_nearest(table);
+        while (tables.size() < count && tables.size() < nearest.size()) {
+            const auto farthest = static_cast<std::size_t>(std::ranges::max_element(nearest) - nearest.begin());
+            if (nearest[farthest] == 0) break;
+            add_landmark(position{farthest % map.width(), farthest / map.width()});
+            update_nearest(tables.back());
+        }
+    }
+
+    void add_landmark(const position &landmark) {
+        tables.push_back({landmark, cell_search(landmark, true), cell_search(landmark, false), {}, {}});
+    }
+
+    // Dijkstra on the cells without the run length limit, away from the landmark or towards it
+    [[nodiscard]] std::vector<distance> cell_search(const position &landmark, bool forward) const {
+        std::vector<unsigned> heat_loss(map.width() * map.height(), heat_loss_algorithm::maximal_heat_loss);
+        using entry = std::pair<unsigned, std::size_t>;
+        std::priority_queue<entry, std::vector<entry>, std::greater<>> queue;
+        heat_loss[cell_index(landmark)] = 0;
+        queue.emplace(0, cell_index(landmark));
+        while (!queue.empty()) {
+            const auto [current_heat_loss, current] = queue.top();
+            queue.pop();
+            if (current_heat_loss != heat_loss[current]) continue;
+
+            const position pos{current % map.width(), current / map.width()};
+            for (const auto dir : heat_loss_state_graph::all_directions) {
+                const auto next_pos = step(map, pos, dir);
+                if (!next_pos) continue;
+                // entering a cell costs its heat loss, backwards the cell we come from is the one entered
+                const auto next = cell_index(*next_pos);
+                const auto tentative = current_heat_loss + map.heat_loss(forward ? *next_pos : pos);
+                if (tentative < heat_loss[next]) {
+                    heat_loss[next] = tentative;
+                    queue.emplace(tentative, next);
+                }
+            }
+        }
+        std::vector<distance> result(heat_loss.size());
+        std::ranges::transform(heat_loss, result.begin(), narrow);
+        return result;
+    }
+
+    // Dijkstra on the state graph, from all states at the landmark or towards any of them
+    [[nodiscard]] std::vector<distance> state_search(const position &landmark, bool forward) const {
+        const row_major_graph graph{map};
+        std::vector<unsigned> heat_loss(graph.size(), heat_loss_algorithm::maximal_heat_loss);
+        heat_loss_span values{heat_loss};
+        auto search = make_state_graph_search(graph, values,
+                                              forward ? search_direction::forward : search_direction::backward);
+        graph.for_each_node_at(landmark, [&](const node &n) { search.reach(n, 0); });
+        search.run();
+        std::vector<distance> result(heat_loss.size());
+        std::ranges::transform(heat_loss, result.begin(), narrow);
+        return result;
+    }
+};
+
+struct alt_search_result {
+    unsigned heat_loss = heat_loss_algorithm::maximal_heat_loss;
+    std::size_t expanded_nodes = 0;
+};
+
+// A* on the state graph with the landmark heuristic. Where a distance did not fit into the tables the heuristic
+// is only admissible, not consistent, so states may be expanded more than once.
+inline alt_search_result alt_search(const alt_landmarks &landmarks, const heat_loss_query &query) {
+    using node = heat_loss_state_graph::node;
+    check_position(landmarks.map, query.source);
+    check_max_count(query);
+    const auto h = landmarks.heuristic_to(query.target);
+    const heat_loss_state_graph graph{landmarks.map};
+    lazy_heat_loss_table heat_loss(graph.size());
+    auto search = make_state_graph_search(graph, heat_loss, search_direction::forward, std::cref(h));
+    search.reach(heat_loss_state_graph::start_node(query.source), 0);
+
+    alt_search_result result;
+    result.heat_loss = search.run([&](const node &n, unsigned) {
+        ++result.expanded_nodes;
+        return n.pos == query.target;
+    });
+    return result;
+}
+
+inline unsigned minimal_heat_loss(const alt_landmarks &landmarks, const heat_loss_query &query) {
+    return alt_search(landmarks, query).heat_loss;
+}
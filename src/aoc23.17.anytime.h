@@ -0,0 +1,177 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <tuple>
+#include <vector>
+
+struct anytime_budget {
+    std::optional<std::chrono::steady_clock::time_point> deadline{};
+    std::optional<std::size_t> max_nodes{};
+};
+
+struct anytime_result {
+    // heat loss of the best path found so far, maximal_heat_loss if there is none yet
+    unsigned upper_bound = heat_loss_algorithm::maximal_heat_loss;
+    // proven: no path can have less heat loss
+    unsigned lower_bound = 0;
+
+    [[nodiscard]] bool exact() const { return upper_bound == lower_bound; }
+};
+
+// Anytime variant of the search for callers with a latency budget: a series of weighted A* searches with decreasing
+// epsilon, each of which finds a path quickly and proves it to be at most epsilon times the optimum. The last one
+// with epsilon 1 is exact. When the budget runs out, the best path so far is returned together with the best
+// proven lower bound, either from the epsilon guarantee or from the open list of the exact search.
+struct heat_loss_algorithm_anytime : heat_loss_algorithm {
+    using node = heat_loss_state_graph::node;
+    using index = heat_loss_state_graph::index;
+
+    static constexpr std::array epsilons{10.0, 4.0, 2.0, 1.5, 1.2, 1.0};
+
+    heat_loss_state_graph graph;
+    position source;
+    position target;
+    unsigned minimal_cell_heat_loss = maximal_heat_loss;
+    lazy_heat_loss_table heat_loss;
+    zeroed_buffer<bool> closed;
+    std::vector<index> touched;
+    std::size_t expanded_nodes = 0;
+
+    heat_loss_algorithm_anytime(city_map_view map, const heat_loss_query &query)
+            : heat_loss_algorithm(map), graph{map}, source(query.source), target(query.target),
+              heat_loss(graph.size()), closed(graph.size()) {
+        check_position(map, source);
+        check_position(map, target);
+        check_max_count(query);
+        for (std::size_t y = 0; y < map.height(); ++y) {
+            for (std::size_t x = 0; x < map.width(); ++x) {
+                minimal_cell_heat_loss = std::min(minimal_cell_heat_loss, map.heat_loss({x, y}));
+            }
+        }
+    }
+
+    explicit heat_loss_algorithm_anytime(city_map &&, const heat_loss_query &) = delete;
+
+    // Every step enters a new cell, so Manhattan distance times the cheapest cell is a consistent heuristic
+    [[nodiscard]] unsigned estimate(const position &pos) const {
+        const auto dx = pos.x > target.x ? pos.x - target.x : target.x - pos.x;
+        const auto dy = pos.y > target.y ? pos.y - target.y : target.y - pos.y;
+        return static_cast<unsigned>(dx + dy) * minimal_cell_heat_loss;
+    }
+
+    anytime_result run(const anytime_budget &budget = {}) {
+        if (source == target) {
+            return {0, 0};
+        }
+
+        anytime_result result{.lower_bound = estimate(source)};
+        for (const auto epsilon : epsilons) {
+            const auto [state, heat_loss_found, open_lower_bound] = weighted_search(epsilon, budget);
+            if (state == search_state::unreachable) {
+                return {maximal_heat_loss, maximal_heat_loss};
+            }
+            if (state == search_state::interrupted) {
+                if (epsilon == 1.0) {
+                    result.lower_bound = std::max(result.lower_bound, open_lower_bound);
+                }
+                break;
+            }
+
+            result.upper_bound = std::min(result.upper_bound, heat_loss_found);
+            result.lower_bound = std::max(result.lower_bound,
+                                          static_cast<unsigned>(std::ceil(heat_loss_found / epsilon - 1e-9)));
+            if (result.lower_bound >= result.upper_bound) {
+                result.lower_bound = result.upper_bound;
+                break;
+            }
+        }
+        return result;
+    }
+
+private:
+    enum class search_state {
+        found,
+        unreachable,
+        interrupted,
+    };
+
+    struct search_result {
+        search_state state;
+        unsigned heat_loss;
+        unsigned open_lower_bound;
+    };
+
+    // open list entries: priority, heat loss when pushed (to skip outdated entries), state
+    using entry = std::tuple<double, unsigned, index>;
+
+    search_result weighted_search(double epsilon, const anytime_budget &budget) {
+        constexpr std::size_t deadline_check_interval = 1024;
+
+        // only undo what the previous search touched, so that restarting stays proportional to the explored region
+        for (const auto i : touched) {
+            heat_loss.reset(i);
+            closed[i] = false;
+        }
+        touched.clear();
+        std::priority_queue<entry, std::vector<entry>, std::greater<>> open;
+
+        const auto push = [&](const node &n, unsigned hl) {
+            const auto i = graph.to_index(n);
+            if (heat_loss.get(i) == maximal_heat_loss) {
+                touched.push_back(i);
+            }
+            heat_loss.set(i, hl);
+            open.emplace(hl + epsilon * estimate(n.pos), hl, i);
+        };
+        push(graph.start_node(source), 0);
+
+        std::size_t until_deadline_check = 1;
+        while (!open.empty()) {
+            const auto [priority, current_heat_loss, current_index] = open.top();
+            if (closed[current_index] || current_heat_loss != heat_loss.get(current_index)) {
+                open.pop();
+                continue;
+            }
+
+            bool out_of_budget = budget.max_nodes && expanded_nodes >= *budget.max_nodes;
+            if (budget.deadline && --until_deadline_check == 0) {
+                until_deadline_check = deadline_check_interval;
+                out_of_budget = out_of_budget || std::chrono::steady_clock::now() >= *budget.deadline;
+            }
+            if (out_of_budget) {
+                // with epsilon 1 the smallest priority in the open list bounds every remaining path
+                return {search_state::interrupted, 0, static_cast<unsigned>(priority)};
+            }
+
+            open.pop();
+            closed[current_index] = true;
+            ++expanded_nodes;
+
+            const auto current = graph.to_node(current_index);
+            if (current.pos == target) {
+                return {search_state::found, current_heat_loss, 0};
+            }
+            graph.for_each_successor(current, [&](const node &next) {
+                const auto next_index = graph.to_index(next);
+                const auto tentative_heat_loss = current_heat_loss + map.heat_loss(next.pos);
+                if (!closed[next_index] && tentative_heat_loss < heat_loss.get(next_index)) {
+                    push(next, tentative_heat_loss);
+                }
+            });
+        }
+        return {search_state::unreachable, 0, 0};
+    }
+};
+
+inline anytime_result minimal_heat_loss_anytime(city_map_view map, const heat_loss_query &query,
+                                                const anytime_budget &budget = {}) {
+    heat_loss_algorithm_anytime algorithm{map, query};
+    return algorithm.run(budget);
+}
@@ -0,0 +1,319 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Lazily started coroutine producing a T. Awaiting it starts it and resumes the awaiting coroutine on whatever
+// thread the task finishes.
+template<typename T>
+class task {
+public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> continuation;
+
+        task get_return_object() {
+            return task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct final_awaiter {
+            bool await_ready() noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                const auto continuation = h.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        final_awaiter final_suspend() noexcept { return {}; }
+
+        void return_value(T v) { value = std::move(v); }
+
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    task(task &&other) noexcept
+            : handle(std::exchange(other.handle, nullptr)) {}
+
+    task &operator=(task &&other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~task() {
+        if (handle) handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    T await_resume() {
+        auto &promise = handle.promise();
+        if (promise.error) {
+            std::rethrow_exception(promise.error);
+        }
+        return std::move(*promise.value);
+    }
+
+private:
+    explicit task(std::coroutine_handle<promise_type> handle)
+            : handle(handle) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Where coroutines continue after `co_await executor.schedule()`
+class executor {
+public:
+    virtual ~executor() = default;
+    virtual void post(std::coroutine_handle<> h) = 0;
+
+    auto schedule() {
+        struct awaiter {
+            executor &target;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { target.post(h); }
+            void await_resume() const noexcept {}
+        };
+        return awaiter{*this};
+    }
+};
+
+// Continues right away on the calling thread
+class inline_executor : public executor {
+public:
+    void post(std::coroutine_handle<> h) override { h.resume(); }
+};
+
+// Fixed number of threads taking coroutines from one queue
+class thread_pool_executor : public executor {
+public:
+    explicit thread_pool_executor(unsigned threads = std::thread::hardware_concurrency()) {
+        for (unsigned i = 0; i < std::max(1u, threads); ++i) {
+            workers.emplace_back([this](std::stop_token stop) { work(stop); });
+        }
+    }
+
+    ~thread_pool_executor() override {
+        for (auto &worker : workers) {
+            worker.request_stop();
+        }
+        ready.notify_all();
+    }
+
+    void post(std::coroutine_handle<> h) override {
+        {
+            std::lock_guard lock{mutex};
+            queue.push_back(h);
+        }
+        ready.notify_one();
+    }
+
+private:
+    void work(std::stop_token stop) {
+        while (true) {
+            std::coroutine_handle<> next;
+            {
+                std::unique_lock lock{mutex};
+                if (!ready.wait(lock, stop, [this] { return !queue.empty(); })) return;
+                next = queue.front();
+                queue.pop_front();
+            }
+            next.resume();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable_any ready;
+    std::deque<std::coroutine_handle<>> queue;
+    std::vector<std::jthread> workers;
+};
+
+// Used by solve_async() when no executor is given, with one thread per core
+inline executor &default_executor() {
+    static thread_pool_executor pool;
+    return pool;
+}
+
+class solve_interrupted : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+struct async_options {
+    executor *on = nullptr;
+    std::stop_token stop{};
+    std::optional<std::chrono::steady_clock::time_point> deadline{};
+};
+
+namespace async_detail {
+
+inline task<unsigned> solve(city_map_view map, heat_loss_query query, async_options options) {
+    co_await (options.on ? *options.on : default_executor()).schedule();
+
+    const auto interrupted = [&options] {
+        return options.stop.stop_requested()
+               || (options.deadline && std::chrono::steady_clock::now() >= *options.deadline);
+    };
+    if (interrupted()) {
+        throw solve_interrupted("query cancelled before it started");
+    }
+
+    heat_loss_algorithm_dijkstra algorithm{map, query.source};
+    if (!algorithm.run_dijkstra(interrupted)) {
+        throw solve_interrupted(options.stop.stop_requested() ? "query cancelled" : "query deadline exceeded");
+    }
+    co_return algorithm.get_minimal_heat_loss(query.target);
+}
+
+}
+
+// Runs one query on the executor. The query is checked right away, while the search only starts once the task is
+// awaited. The map has to outlive the task. Cancellation through the stop token and the deadline are checked before
+// the search starts and periodically inside it; both end the task with solve_interrupted.
+inline task<unsigned> solve_async(city_map_view map, heat_loss_query query, async_options options = {}) {
+    check_position(map, query.source);
+    check_position(map, query.target);
+    check_max_count(query);
+    return async_detail::solve(map, query, std::move(options));
+}
+
+// The task would outlive a temporary map
+task<unsigned> solve_async(city_map &&, heat_loss_query, async_options = {}) = delete;
+
+namespace async_detail {
+
+struct fire_and_forget {
+    struct promise_type {
+        fire_and_forget get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+template<typename T>
+struct when_all_state {
+    explicit when_all_state(std::size_t count)
+            : results(count), remaining(count + 1) {}
+
+    std::vector<std::optional<T>> results;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::atomic<std::size_t> remaining;
+    std::coroutine_handle<> continuation;
+
+    // the awaiting coroutine is resumed by whoever finishes last, including the starting loop itself
+    void finish_one() {
+        if (remaining.fetch_sub(1) == 1) {
+            continuation.resume();
+        }
+    }
+};
+
+template<typename T>
+fire_and_forget drive(task<T> &t, std::size_t i, when_all_state<T> &state) {
+    try {
+        state.results[i] = co_await t;
+    } catch (...) {
+        std::lock_guard lock{state.error_mutex};
+        if (!state.error) state.error = std::current_exception();
+    }
+    state.finish_one();
+}
+
+template<typename T>
+struct when_all_awaiter {
+    std::vector<task<T>> &tasks;
+    when_all_state<T> &state;
+
+    bool await_ready() const noexcept { return tasks.empty(); }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        state.continuation = h;
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            drive(tasks[i], i, state);
+        }
+        state.finish_one();
+    }
+
+    void await_resume() const noexcept {}
+};
+
+template<typename T>
+fire_and_forget signal_when_done(task<T> &t, std::optional<T> &result, std::exception_ptr &error,
+                                 std::mutex &mutex, std::condition_variable &done_signal, bool &done) {
+    try {
+        result = co_await t;
+    } catch (...) {
+        error = std::current_exception();
+    }
+    std::lock_guard lock{mutex};
+    done = true;
+    done_signal.notify_one();
+}
+
+}
+
+// Awaits all tasks concurrently, results in the order of the tasks. The first exception is rethrown once all tasks
+// are finished.
+template<typename T>
+task<std::vector<T>> when_all(std::vector<task<T>> tasks) {
+    async_detail::when_all_state<T> state{tasks.size()};
+    co_await async_detail::when_all_awaiter<T>{tasks, state};
+
+    if (state.error) {
+        std::rethrow_exception(state.error);
+    }
+    std::vector<T> results;
+    results.reserve(state.results.size());
+    for (auto &result : state.results) {
+        results.push_back(std::move(*result));
+    }
+    co_return results;
+}
+
+// Blocks the calling thread until the task is finished, for callers outside of coroutines
+template<typename T>
+T sync_wait(task<T> t) {
+    std::optional<T> result;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable done_signal;
+    bool done = false;
+
+    async_detail::signal_when_done(t, result, error, mutex, done_signal, done);
+
+    std::unique_lock lock{mutex};
+    done_signal.wait(lock, [&done] { return done; });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return std::move(*result);
+}
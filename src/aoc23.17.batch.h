@@ -0,0 +1,309 @@
+#pragma once
+
+#include "aoc23.17.h"
+#include "aoc23.17.relax.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+// Solves up to `lanes` maps of the same size at once with the passes of heat_loss_algorithm_sweep. The states are
+// stored like state_planes, except that every state holds one value per map next to each other, so a single AVX2
+// instruction relaxes the same state in all maps of the batch. The maps take the same number of instructions
+// whatever their heat losses, and the batch runs until the last of them has converged. With 32 bit lanes a batch
+// holds 8 maps, with 16 bit lanes 16, as long as the heat losses of the paths fit into them.
+template<typename Lane>
+class basic_heat_loss_batch {
+public:
+    using position = city_map::position;
+    static constexpr std::size_t lanes = 32 / sizeof(Lane);
+    // far enough below the maximum that adding one heat loss cannot overflow
+    static constexpr Lane unreached = std::numeric_limits<Lane>::max() / 2;
+    static constexpr std::size_t max_count = state_planes::max_count;
+    static constexpr std::size_t plane_count = state_planes::plane_count;
+
+    explicit basic_heat_loss_batch(std::span<const city_map_view> maps,
+                                   position source = heat_loss_algorithm::initial_position,
+                                   relax_kernel kernel = best_relax_kernel())
+            : maps(maps.size()), kernel(kernel), columns(maps.empty() ? 0 : maps.front().width()),
+              rows(maps.empty() ? 0 : maps.front().height()), padded_width(columns + 2),
+              plane_size(padded_width * (rows + 2)), weights(columns * rows * lanes),
+              values(plane_count * plane_size * lanes, unreached) {
+        if (maps.empty() || maps.size() > lanes) {
+            throw std::invalid_argument(std::format("a batch takes 1 to {} maps, not {}", lanes, maps.size()));
+        }
+        unsigned largest = 0;
+        for (std::size_t lane = 0; lane < maps.size(); ++lane) {
+            const auto &map = maps[lane];
+            if (map.width() != columns || map.height() != rows) {
+                throw std::invalid_argument(std::format("map {} is {}x{}, the batch is {}x{}",
+                                                        lane, map.width(), map.height(), columns, rows));
+            }
+            for (std::size_t y = 0; y < rows; ++y) {
+                const auto *cells = map.row_data(y);
+                for (std::size_t x = 0; x < columns; ++x) {
+                    weights[(y * columns + x) * lanes + lane] = static_cast<Lane>(cells[x]);
+                    largest = std::max(largest, cells[x]);
+                }
+            }
+        }
+        if (!fits(columns, rows, largest)) {
+            throw std::invalid_argument(std::format("heat losses up to {} on {}x{} maps do not fit into {} bit lanes",
+                                                    largest, columns, rows, sizeof(Lane) * 8));
+        }
+        check_position(*this, source);
+        const auto start = heat_loss_state_graph::start_node(source);
+        auto *first = state(start.history.dir, start.history.count, padded_index(source));
+        std::fill(first, first + maps.size(), Lane{0});
+    }
+
+    // Whether the cheapest paths to all states surely fit into a lane: any state can be reached by a staircase
+    // to the cell before it and a few steps around, which is well within twice the perimeter
+    [[nodiscard]] static bool fits(std::size_t width, std::size_t height, unsigned largest_heat_loss) {
+        return std::uint64_t{largest_heat_loss} * 2 * (width + height + 8) < unreached;
+    }
+
+    [[nodiscard]] std::size_t size() const { return maps; }
+    [[nodiscard]] std::size_t width() const { return columns; }
+    [[nodiscard]] std::size_t height() const { return rows; }
+
+    std::size_t sweeps = 0;
+    bool converged = false;
+
+    [[nodiscard]] std::size_t default_max_sweeps() const {
+        return columns * rows * plane_count;
+    }
+
+    // Sweeps until all maps converged or until max_sweeps passes in total were made, returns whether it converged.
+    // Can be called again to continue with a larger cap.
+    bool run(std::optional<std::size_t> max_sweeps = std::nullopt) {
+        const auto cap = max_sweeps.value_or(default_max_sweeps());
+        while (!converged && sweeps < cap) {
+            const auto order = sweeps % 2 == 0 ? sweep_order::top_down : sweep_order::bottom_up;
+            bool changed = false;
+            for (std::size_t i = 0; i < rows; ++i) {
+                const auto y = order == sweep_order::top_down ? i : rows - 1 - i;
+                changed = relax_row(y) || changed;
+            }
+            converged = !changed;
+            ++sweeps;
+        }
+        return converged;
+    }
+
+    // Exact once converged, otherwise the heat loss of the best path found so far
+    [[nodiscard]] unsigned get_minimal_heat_loss(std::size_t map, const position &target) const {
+        if (map >= maps) {
+            throw std::out_of_range(std::format("map {} outside of a batch of {}", map, maps));
+        }
+        check_position(*this, target);
+        Lane minimum = unreached;
+        for (auto dir : heat_loss_state_graph::all_directions) {
+            for (unsigned count = 1; count <= max_count; ++count) {
+                minimum = std::min(minimum, state(dir, count, padded_index(target))[map]);
+            }
+        }
+        return minimum == unreached ? heat_loss_algorithm::maximal_heat_loss : minimum;
+    }
+
+    [[nodiscard]] unsigned get_minimal_heat_loss(std::size_t map) const {
+        return get_minimal_heat_loss(map, position{columns - 1, rows - 1});
+    }
+
+private:
+    std::size_t maps;
+    relax_kernel kernel;
+    std::size_t columns;
+    std::size_t rows;
+    std::size_t padded_width;
+    std::size_t plane_size;
+    // cell after cell, the maps of a cell next to each other; lanes without a map weigh nothing and stay unreached
+    std::vector<Lane> weights;
+    std::vector<Lane> values;
+
+    [[nodiscard]] std::size_t padded_index(const position &pos) const {
+        return (pos.y + 1) * padded_width + pos.x + 1;
+    }
+
+    [[nodiscard]] Lane *state(direction dir, unsigned count, std::size_t cell) {
+        return values.data() + ((static_cast<std::size_t>(dir) * max_count + count - 1) * plane_size + cell) * lanes;
+    }
+
+    [[nodiscard]] const Lane *state(direction dir, unsigned count, std::size_t cell) const {
+        return values.data() + ((static_cast<std::size_t>(dir) * max_count + count - 1) * plane_size + cell) * lanes;
+    }
+
+    // Offset in cells to the cell a step in `dir` comes from
+    [[nodiscard]] std::ptrdiff_t from_offset(direction dir) const {
+        const auto row = static_cast<std::ptrdiff_t>(padded_width);
+        switch (dir) {
+            case direction::NORTH:
+                return row;
+            case direction::SOUTH:
+                return -row;
+            case direction::EAST:
+                return -1;
+            case direction::WEST:
+                return 1;
+        }
+        return 0;
+    }
+
+    bool relax_row(std::size_t y) {
+#if AOC_HAVE_AVX2_KERNEL
+        if (kernel == relax_kernel::avx2) {
+            return relax_row_avx2(y);
+        }
+#endif
+        return relax_row_scalar(y);
+    }
+
+    // Same as relax_detail::relax_row_scalar, for every map of the batch
+    bool relax_row_scalar(std::size_t y) {
+        bool changed = false;
+        for (auto dir : heat_loss_state_graph::all_directions) {
+            const auto from = from_offset(dir);
+            const auto [left, right] = turns(dir);
+            for (std::size_t x = 0; x < columns; ++x) {
+                const auto cell = padded_index({x, y});
+                const auto *w = weights.data() + (y * columns + x) * lanes;
+                for (std::size_t lane = 0; lane < lanes; ++lane) {
+                    Lane turn = unreached;
+                    for (unsigned count = 1; count <= max_count; ++count) {
+                        turn = std::min({turn, state(left, count, cell + from)[lane],
+                                         state(right, count, cell + from)[lane]});
+                    }
+                    Lane previous = turn;
+                    for (unsigned count = 1; count <= max_count; ++count) {
+                        auto &value = state(dir, count, cell)[lane];
+                        const auto candidate = static_cast<Lane>(std::min<unsigned>(previous + w[lane], unreached));
+                        previous = state(dir, count, cell + from)[lane];
+                        if (candidate < value) {
+                            value = candidate;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        }
+        return changed;
+    }
+
+#if AOC_HAVE_AVX2_KERNEL
+    __attribute__((target("avx2")))
+    static __m256i load(const Lane *p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i min(__m256i a, __m256i b) {
+        if constexpr (sizeof(Lane) == 4) {
+            return _mm256_min_epu32(a, b);
+        } else {
+            return _mm256_min_epu16(a, b);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i add(__m256i a, __m256i b) {
+        if constexpr (sizeof(Lane) == 4) {
+            return _mm256_add_epi32(a, b);
+        } else {
+            return _mm256_adds_epu16(a, b);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i equal(__m256i a, __m256i b) {
+        if constexpr (sizeof(Lane) == 4) {
+            return _mm256_cmpeq_epi32(a, b);
+        } else {
+            return _mm256_cmpeq_epi16(a, b);
+        }
+    }
+
+    // One cell of all maps per instruction
+    __attribute__((target("avx2")))
+    bool relax_row_avx2(std::size_t y) {
+        __m256i limit;
+        if constexpr (sizeof(Lane) == 4) {
+            limit = _mm256_set1_epi32(static_cast<int>(unreached));
+        } else {
+            limit = _mm256_set1_epi16(static_cast<short>(unreached));
+        }
+        __m256i any_change = _mm256_setzero_si256();
+        for (auto dir : heat_loss_state_graph::all_directions) {
+            const auto from = from_offset(dir);
+            const auto [left, right] = turns(dir);
+            for (std::size_t x = 0; x < columns; ++x) {
+                const auto cell = padded_index({x, y});
+                const auto w = load(weights.data() + (y * columns + x) * lanes);
+
+                auto previous = limit;
+                for (unsigned count = 1; count <= max_count; ++count) {
+                    previous = min(previous, load(state(left, count, cell + from)));
+                    previous = min(previous, load(state(right, count, cell + from)));
+                }
+                for (unsigned count = 1; count <= max_count; ++count) {
+                    auto *target = state(dir, count, cell);
+                    const auto value = load(target);
+                    const auto relaxed = min(value, min(add(previous, w), limit));
+                    any_change = _mm256_or_si256(any_change, _mm256_xor_si256(equal(relaxed, value),
+                                                                              _mm256_set1_epi32(-1)));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(target), relaxed);
+                    previous = load(state(dir, count, cell + from));
+                }
+            }
+        }
+        return !_mm256_testz_si256(any_change, any_change);
+    }
+#endif
+};
+
+// 8 maps per batch
+using heat_loss_batch = basic_heat_loss_batch<std::uint32_t>;
+// 16 maps per batch, for maps small enough and heat losses low enough
+using heat_loss_batch16 = basic_heat_loss_batch<std::uint16_t>;
+
+// The answers to one query on each of the maps, which must all have the same size. They are solved in batches of 16
+// when their heat losses fit into 16 bits, of 8 otherwise. Throws std::invalid_argument if a map differs in size from
+// the first one.
+inline std::vector<unsigned> minimal_heat_loss_batch(std::span<const city_map> maps, const heat_loss_query &query) {
+    check_max_count(query);
+    std::vector<city_map_view> views(maps.begin(), maps.end());
+    const auto width = views.empty() ? 0 : views.front().width();
+    const auto height = views.empty() ? 0 : views.front().height();
+    unsigned largest = 0;
+    for (std::size_t i = 0; i < views.size(); ++i) {
+        const auto &map = views[i];
+        if (map.width() != width || map.height() != height) {
+            throw std::invalid_argument(std::format("map {} is {}x{}, the first map is {}x{}",
+                                                    i, map.width(), map.height(), width, height));
+        }
+        for (std::size_t y = 0; y < map.height(); ++y) {
+            largest = std::max(largest, *std::max_element(map.row_data(y), map.row_data(y) + map.width()));
+        }
+    }
+    std::vector<unsigned> result;
+    result.reserve(maps.size());
+    const auto solve = [&]<typename Batch>() {
+        for (std::size_t first = 0; first < views.size(); first += Batch::lanes) {
+            Batch batch{std::span(views).subspan(first, std::min(Batch::lanes, views.size() - first)), query.source};
+            batch.run();
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                result.push_back(batch.get_minimal_heat_loss(i, query.target));
+            }
+        }
+    };
+    if (!views.empty() && heat_loss_batch16::fits(width, height, largest)) {
+        solve.template operator()<heat_loss_batch16>();
+    } else {
+        solve.template operator()<heat_loss_batch>();
+    }
+    return result;
+}
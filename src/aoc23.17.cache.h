@@ -0,0 +1,105 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+// LRU cache for solver results, keyed by the content hash of the map and the query. The number of entries is
+// derived from a memory budget. Lookups neither allocate nor copy the map, so a hit costs one hash of the key.
+class heat_loss_cache {
+public:
+    struct key {
+        std::uint64_t map_hash;
+        heat_loss_query query;
+
+        auto operator<=>(const key &) const = default;
+    };
+
+private:
+    using usage_list = std::list<std::pair<key, unsigned>>;
+
+public:
+    // list node plus hash table node and bucket, roughly
+    static constexpr std::size_t bytes_per_entry = sizeof(usage_list::value_type) + 2 * sizeof(void *)
+                                                   + sizeof(key) + sizeof(usage_list::iterator) + 3 * sizeof(void *);
+
+    explicit heat_loss_cache(std::size_t max_bytes)
+            : capacity(std::max<std::size_t>(1, max_bytes / bytes_per_entry)) {}
+
+    template<typename Solve>
+    unsigned get_or_solve(const key &k, Solve &&solve) {
+        {
+            std::lock_guard lock{mutex};
+            if (const auto it = entries.find(k); it != entries.end()) {
+                ++hit_count;
+                usage.splice(usage.begin(), usage, it->second);
+                return it->second->second;
+            }
+            ++miss_count;
+        }
+
+        const unsigned result = solve();
+
+        std::lock_guard lock{mutex};
+        if (entries.contains(k)) {
+            return result;
+        }
+        if (entries.size() == capacity) {
+            entries.erase(usage.back().first);
+            usage.pop_back();
+        }
+        usage.emplace_front(k, result);
+        entries.emplace(k, usage.begin());
+        return result;
+    }
+
+    [[nodiscard]] std::size_t hits() const {
+        std::lock_guard lock{mutex};
+        return hit_count;
+    }
+
+    [[nodiscard]] std::size_t misses() const {
+        std::lock_guard lock{mutex};
+        return miss_count;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        std::lock_guard lock{mutex};
+        return entries.size();
+    }
+
+    [[nodiscard]] std::size_t max_size() const {
+        return capacity;
+    }
+
+private:
+    struct key_hash {
+        std::size_t operator()(const key &k) const {
+            auto h = k.map_hash;
+            for (const auto value : {k.query.source.x, k.query.source.y, k.query.target.x, k.query.target.y,
+                                     std::size_t{k.query.max_count}}) {
+                h = std::rotl(h ^ value, 29) * 0x9e3779b185ebca87ULL;
+            }
+            return static_cast<std::size_t>(h);
+        }
+    };
+
+    std::size_t capacity;
+    mutable std::mutex mutex;
+    usage_list usage;
+    std::unordered_map<key, usage_list::iterator, key_hash> entries;
+    std::size_t hit_count = 0;
+    std::size_t miss_count = 0;
+};
+
+inline unsigned minimal_heat_loss(heat_loss_cache &cache, const city_map &map, const heat_loss_query &query) {
+    return cache.get_or_solve({map.content_hash(), query}, [&map, &query] { return minimal_heat_loss(map, query); });
+}
+
+inline unsigned minimal_heat_loss(heat_loss_cache &cache, const city_map &map) {
+    return minimal_heat_loss(cache, map, heat_loss_query::whole_map(map));
+}
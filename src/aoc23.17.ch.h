@@ -0,0 +1,575 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Contraction hierarchy over the turns of one static map. Like the jump engine it leaves out the states in the
+// middle of straight runs: a state is a cell together with the axis of the next run, and an edge is a whole run of
+// one to max_count cells, so a cell has two states instead of twelve. A third state per cell starts a search there,
+// with the runs that the initial state of the puzzle allows. Preprocessing removes the states one by one in order of
+// importance and adds shortcuts wherever a removed state was needed for a cheapest path between its remaining
+// neighbours. A query then only searches upwards in that order, forwards from the source and backwards from the
+// target, which settles a tiny part of the graph. Preprocessing contracts an independent set of states per round in
+// parallel, and the result can be saved next to the map.
+class contraction_hierarchy {
+public:
+    using position = city_map::position;
+    using index = std::uint32_t;
+
+    struct edge {
+        index to;
+        unsigned heat_loss;
+    };
+
+    enum class state_kind : std::uint8_t {
+        // entered vertically, the next run goes east or west
+        horizontal,
+        // entered horizontally, the next run goes north or south
+        vertical,
+        start,
+    };
+    static constexpr std::size_t states_per_cell = 3;
+    static constexpr unsigned max_count = heat_loss_state_graph::step_history::max_count;
+
+    // Contracts the state graph of map on up to `threads` threads
+    static contraction_hierarchy compute(const city_map &map, unsigned threads = std::thread::hardware_concurrency()) {
+        contraction_hierarchy hierarchy{map.width(), map.height(), map.content_hash()};
+        builder{map, std::max(1u, threads)}.contract(hierarchy);
+        return hierarchy;
+    }
+
+    [[nodiscard]] std::size_t width() const { return columns; }
+    [[nodiscard]] std::size_t height() const { return rows; }
+    [[nodiscard]] std::size_t node_count() const { return columns * rows * states_per_cell; }
+    [[nodiscard]] std::size_t edge_count() const { return forward_edges.size() + backward_edges.size(); }
+
+    // Row major state numbering, independent of the layout of the build so that files can be shared
+    [[nodiscard]] index to_index(const position &pos, state_kind kind) const {
+        return to_index(columns, pos, kind);
+    }
+
+    // Edges to states contracted later, leaving v
+    [[nodiscard]] std::span<const edge> upward_forward(index v) const {
+        return {forward_edges.data() + forward_offsets[v], forward_edges.data() + forward_offsets[v + 1]};
+    }
+
+    // Edges from states contracted later, entering v, reversed
+    [[nodiscard]] std::span<const edge> upward_backward(index v) const {
+        return {backward_edges.data() + backward_offsets[v], backward_edges.data() + backward_offsets[v + 1]};
+    }
+
+    void save(std::ostream &out) const {
+        const file_header header{
+                .width = static_cast<std::uint32_t>(columns),
+                .height = static_cast<std::uint32_t>(rows),
+                .version = file_version,
+                .forward_edges = forward_edges.size(),
+                .backward_edges = backward_edges.size(),
+                .map_hash = map_hash,
+        };
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        write_array(out, forward_offsets);
+        write_array(out, forward_edges);
+        write_array(out, backward_offsets);
+        write_array(out, backward_edges);
+        if (!out) {
+            throw std::runtime_error("could not write contraction hierarchy");
+        }
+    }
+
+    // Throws std::runtime_error if the data is damaged or belongs to another map
+    static contraction_hierarchy load(std::istream &in, const city_map &map) {
+        file_header header;
+        if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.magic != file_magic) {
+            throw std::runtime_error("not a contraction hierarchy");
+        }
+        if (header.version != file_version) {
+            throw std::runtime_error(std::format("contraction hierarchy of version {}, expected {}",
+                                                 header.version, file_version));
+        }
+        if (header.width != map.width() || header.height != map.height() || header.map_hash != map.content_hash()) {
+            throw std::runtime_error(std::format(
+                    "contraction hierarchy of a {}x{} map does not belong to this {}x{} map",
+                    header.width, header.height, map.width(), map.height()));
+        }
+        contraction_hierarchy hierarchy{map.width(), map.height(), header.map_hash};
+        const auto offset_count = hierarchy.node_count() + 1;
+        if (!read_array(in, hierarchy.forward_offsets, offset_count)
+            || !read_array(in, hierarchy.forward_edges, header.forward_edges)
+            || !read_array(in, hierarchy.backward_offsets, offset_count)
+            || !read_array(in, hierarchy.backward_edges, header.backward_edges)) {
+            throw std::runtime_error("truncated contraction hierarchy");
+        }
+        for (const auto &offsets : {hierarchy.forward_offsets, hierarchy.backward_offsets}) {
+            if (!std::ranges::is_sorted(offsets) || offsets.front() != 0) {
+                throw std::runtime_error("damaged contraction hierarchy");
+            }
+        }
+        if (hierarchy.forward_offsets.back() != header.forward_edges
+            || hierarchy.backward_offsets.back() != header.backward_edges) {
+            throw std::runtime_error("damaged contraction hierarchy");
+        }
+        // a shortcut stands for a path that visits every state at most once, with runs of up to max_count cells
+        unsigned largest_cell = 0;
+        for (std::size_t y = 0; y < map.height(); ++y) {
+            for (std::size_t x = 0; x < map.width(); ++x) {
+                largest_cell = std::max(largest_cell, map.heat_loss({x, y}));
+            }
+        }
+        const auto max_heat_loss = std::uint64_t{largest_cell} * max_count * hierarchy.node_count();
+        for (const auto &edges : {std::span<const edge>(hierarchy.forward_edges),
+                                  std::span<const edge>(hierarchy.backward_edges)}) {
+            for (const auto &e : edges) {
+                if (e.to >= hierarchy.node_count() || e.heat_loss > max_heat_loss) {
+                    throw std::runtime_error("damaged contraction hierarchy");
+                }
+            }
+        }
+        return hierarchy;
+    }
+
+private:
+    static constexpr std::uint32_t file_magic = 0x48434f41; // "AOCH"
+    // 1 contracted the full state graph
+    static constexpr std::uint32_t file_version = 2;
+
+    struct file_header {
+        std::uint32_t magic = file_magic;
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        std::uint32_t version = 0;
+        std::uint64_t forward_edges = 0;
+        std::uint64_t backward_edges = 0;
+        std::uint64_t map_hash = 0;
+    };
+
+    std::size_t columns;
+    std::size_t rows;
+    std::uint64_t map_hash;
+    // upward graphs in compressed sparse row form
+    std::vector<std::uint64_t> forward_offsets;
+    std::vector<edge> forward_edges;
+    std::vector<std::uint64_t> backward_offsets;
+    std::vector<edge> backward_edges;
+
+    contraction_hierarchy(std::size_t width, std::size_t height, std::uint64_t map_hash)
+            : columns(width), rows(height), map_hash(map_hash) {}
+
+    [[nodiscard]] static index to_index(std::size_t width, const position &pos, state_kind kind) {
+        return static_cast<index>((pos.y * width + pos.x) * states_per_cell + static_cast<std::size_t>(kind));
+    }
+
+    template<typename T>
+    static void write_array(std::ostream &out, const std::vector<T> &values) {
+        out.write(reinterpret_cast<const char *>(values.data()),
+                  static_cast<std::streamsize>(values.size() * sizeof(T)));
+    }
+
+    // Reads in chunks, so that a damaged count ends with the data instead of allocating all of it up front
+    template<typename T>
+    static bool read_array(std::istream &in, std::vector<T> &values, std::uint64_t count) {
+        constexpr std::uint64_t chunk = 1 << 16;
+        values.clear();
+        while (values.size() < count) {
+            const auto begin = values.size();
+            values.resize(begin + std::min(chunk, count - begin));
+            if (!in.read(reinterpret_cast<char *>(values.data() + begin),
+                         static_cast<std::streamsize>((values.size() - begin) * sizeof(T)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Graph of the states not contracted yet, shrinking round by round
+    class builder {
+    public:
+        builder(const city_map &map, unsigned threads)
+                : threads(threads) {
+            const auto count = map.width() * map.height() * states_per_cell;
+            out_edges.resize(count);
+            in_edges.resize(count);
+            // the runs of up to `length` cells from pos in direction dir, each ending with a turn
+            const auto add_runs = [&](const position &from, state_kind kind, direction dir, unsigned length) {
+                const auto from_index = to_index(map.width(), from, kind);
+                const auto arrival = dir == direction::NORTH || dir == direction::SOUTH ? state_kind::horizontal
+                                                                                        : state_kind::vertical;
+                auto pos = from;
+                unsigned heat_loss = 0;
+                for (unsigned i = 0; i < length; ++i) {
+                    const auto next = step(map, pos, dir);
+                    if (!next) break;
+                    pos = *next;
+                    heat_loss += map.heat_loss(pos);
+                    const auto to = to_index(map.width(), pos, arrival);
+                    out_edges[from_index].push_back({to, heat_loss});
+                    in_edges[to].push_back({from_index, heat_loss});
+                }
+            };
+            const auto initial = heat_loss_algorithm_dijkstra::initial_node.history;
+            for (std::size_t y = 0; y < map.height(); ++y) {
+                for (std::size_t x = 0; x < map.width(); ++x) {
+                    const position pos{x, y};
+                    for (const auto dir : heat_loss_state_graph::all_directions) {
+                        const bool vertical = dir == direction::NORTH || dir == direction::SOUTH;
+                        add_runs(pos, vertical ? state_kind::vertical : state_kind::horizontal, dir, max_count);
+                        // the start has entered in the initial direction, so it may not go back and goes on for
+                        // fewer cells
+                        if (dir == initial.dir) {
+                            add_runs(pos, state_kind::start, dir, max_count - initial.count);
+                        } else if (dir != opposite(initial.dir)) {
+                            add_runs(pos, state_kind::start, dir, max_count);
+                        }
+                    }
+                }
+            }
+            contracted.assign(count, false);
+            contracting.assign(count, false);
+            deleted_neighbors.assign(count, 0);
+            level.assign(count, 0);
+            priority.assign(count, 0);
+            workspaces.resize(threads, witness_workspace(count));
+        }
+
+        void contract(contraction_hierarchy &hierarchy) {
+            const auto count = static_cast<index>(out_edges.size());
+            std::vector<std::vector<edge>> upward_forward(count);
+            std::vector<std::vector<edge>> upward_backward(count);
+
+            std::vector<index> remaining(count);
+            for (index v = 0; v < count; ++v) remaining[v] = v;
+            parallel_for(remaining.size(), [&](std::size_t i, witness_workspace &workspace) {
+                priority[remaining[i]] = compute_priority(remaining[i], workspace);
+            });
+
+            // Priorities are only brought up to date for the candidates of a round, i.e. the states whose possibly
+            // outdated priority is lower than that of all their neighbours. The candidates are independent, so their
+            // shortcuts can be searched in parallel while all of them are left out of the witness searches, and
+            // those that stay local minima with the new priority are contracted together.
+            std::vector<std::vector<shortcut>> shortcuts;
+            while (!remaining.empty()) {
+                std::vector<index> candidates;
+                for (const auto v : remaining) {
+                    if (is_local_minimum(v)) candidates.push_back(v);
+                }
+                for (const auto v : candidates) contracting[v] = true;
+                shortcuts.assign(candidates.size(), {});
+                parallel_for(candidates.size(), [&](std::size_t i, witness_workspace &workspace) {
+                    const auto v = candidates[i];
+                    find_shortcuts(v, workspace, shortcuts[i]);
+                    priority[v] = edge_difference_priority(v, shortcuts[i].size());
+                });
+
+                for (std::size_t i = 0; i < candidates.size(); ++i) {
+                    const auto v = candidates[i];
+                    if (is_local_minimum(v)) {
+                        contract_node(v, shortcuts[i], upward_forward[v], upward_backward[v]);
+                    }
+                }
+                for (const auto v : candidates) contracting[v] = false;
+                std::erase_if(remaining, [this](index v) { return contracted[v]; });
+            }
+
+            const auto flatten = [](std::vector<std::vector<edge>> &lists, std::vector<std::uint64_t> &offsets,
+                                    std::vector<edge> &edges) {
+                offsets.assign(1, 0);
+                for (auto &list : lists) {
+                    edges.insert(edges.end(), list.begin(), list.end());
+                    offsets.push_back(edges.size());
+                    list = {};
+                }
+            };
+            flatten(upward_forward, hierarchy.forward_offsets, hierarchy.forward_edges);
+            flatten(upward_backward, hierarchy.backward_offsets, hierarchy.backward_edges);
+        }
+
+    private:
+        struct shortcut {
+            index from;
+            index to;
+            unsigned heat_loss;
+        };
+
+        using witness_entry = std::pair<unsigned, index>;
+
+        // Bounded Dijkstra scratch space of one thread, only the touched entries are reset
+        struct witness_workspace {
+            explicit witness_workspace(std::size_t count)
+                    : heat_loss(count, heat_loss_algorithm::maximal_heat_loss),
+                      witness_limit(count, heat_loss_algorithm::maximal_heat_loss) {}
+
+            std::vector<unsigned> heat_loss;
+            // for the out neighbours of the contracted state that still lack a witness: the heat loss via that state
+            std::vector<unsigned> witness_limit;
+            std::vector<index> targets;
+            std::vector<index> touched;
+            std::vector<witness_entry> queue;
+        };
+
+        // searches for witnesses give up after this many states, which only costs superfluous shortcuts
+        static constexpr std::size_t witness_settle_limit = 1024;
+
+        unsigned threads;
+        std::vector<std::vector<edge>> out_edges;
+        std::vector<std::vector<edge>> in_edges;
+        std::vector<bool> contracted;
+        std::vector<bool> contracting;
+        std::vector<unsigned> deleted_neighbors;
+        std::vector<unsigned> level;
+        std::vector<int> priority;
+        std::vector<witness_workspace> workspaces;
+
+        template<typename F>
+        void parallel_for(std::size_t count, F &&f) {
+            std::atomic<std::size_t> next = 0;
+            const auto work = [&](witness_workspace &workspace) {
+                constexpr std::size_t chunk = 64;
+                for (auto begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk)) {
+                    for (auto i = begin; i < std::min(begin + chunk, count); ++i) f(i, workspace);
+                }
+            };
+            std::vector<std::jthread> pool;
+            for (unsigned t = 1; t < threads; ++t) {
+                pool.emplace_back([&work, this, t] { work(workspaces[t]); });
+            }
+            work(workspaces[0]);
+        }
+
+        [[nodiscard]] bool is_local_minimum(index v) const {
+            const auto before = [this](index a, index b) {
+                return priority[a] != priority[b] ? priority[a] < priority[b] : a < b;
+            };
+            for (const auto *edges : {&out_edges[v], &in_edges[v]}) {
+                for (const auto &e : *edges) {
+                    if (!before(v, e.to)) return false;
+                }
+            }
+            return true;
+        }
+
+        void add_edge(index from, index to, unsigned heat_loss) {
+            const auto update = [](std::vector<edge> &edges, index other, unsigned heat_loss) {
+                const auto it = std::ranges::find_if(edges, [other](const edge &e) { return e.to == other; });
+                if (it == edges.end()) {
+                    edges.push_back({other, heat_loss});
+                } else {
+                    it->heat_loss = std::min(it->heat_loss, heat_loss);
+                }
+            };
+            update(out_edges[from], to, heat_loss);
+            update(in_edges[to], from, heat_loss);
+        }
+
+        // Cheapest distances from `from` without v and the states contracted in this round, until each of the
+        // workspace targets has been reached at most at its witness_limit. Nothing beyond the largest witness_limit
+        // still open can be a witness, so the search stops there.
+        void witness_search(index from, index v, witness_workspace &workspace) const {
+            for (const auto i : workspace.touched) workspace.heat_loss[i] = heat_loss_algorithm::maximal_heat_loss;
+            workspace.touched.clear();
+
+            const auto open_limit = [&workspace] {
+                unsigned limit = 0;
+                for (const auto t : workspace.targets) {
+                    if (workspace.witness_limit[t] != heat_loss_algorithm::maximal_heat_loss) {
+                        limit = std::max(limit, workspace.witness_limit[t]);
+                    }
+                }
+                return limit;
+            };
+            auto limit = open_limit();
+            auto targets = workspace.targets.size();
+
+            auto &queue = workspace.queue;
+            queue.clear();
+            workspace.heat_loss[from] = 0;
+            workspace.touched.push_back(from);
+            queue.emplace_back(0, from);
+            std::size_t settled = 0;
+            while (!queue.empty() && settled < witness_settle_limit && targets > 0) {
+                std::ranges::pop_heap(queue, std::greater<>{});
+                const auto [current_heat_loss, current] = queue.back();
+                queue.pop_back();
+                if (current_heat_loss != workspace.heat_loss[current]) continue;
+                if (current_heat_loss > limit) break;
+                ++settled;
+                for (const auto &e : out_edges[current]) {
+                    if (e.to == v || contracting[e.to]) continue;
+                    const auto tentative = current_heat_loss + e.heat_loss;
+                    if (tentative > limit || tentative >= workspace.heat_loss[e.to]) continue;
+                    if (workspace.heat_loss[e.to] == heat_loss_algorithm::maximal_heat_loss) {
+                        workspace.touched.push_back(e.to);
+                    }
+                    workspace.heat_loss[e.to] = tentative;
+                    queue.emplace_back(tentative, e.to);
+                    std::ranges::push_heap(queue, std::greater<>{});
+                    // a witness needs not be the cheapest path, so the target is done as soon as one is found
+                    auto &witness_limit = workspace.witness_limit[e.to];
+                    if (witness_limit != heat_loss_algorithm::maximal_heat_loss && tentative <= witness_limit) {
+                        witness_limit = heat_loss_algorithm::maximal_heat_loss;
+                        --targets;
+                        limit = open_limit();
+                    }
+                }
+            }
+        }
+
+        template<typename F>
+        void for_each_needed_shortcut(index v, witness_workspace &workspace, F &&f) const {
+            for (const auto &in : in_edges[v]) {
+                workspace.targets.clear();
+                for (const auto &out : out_edges[v]) {
+                    if (out.to == in.to) continue;
+                    workspace.witness_limit[out.to] = in.heat_loss + out.heat_loss;
+                    workspace.targets.push_back(out.to);
+                }
+                witness_search(in.to, v, workspace);
+                for (const auto t : workspace.targets) {
+                    // still set if no witness was found
+                    if (workspace.witness_limit[t] != heat_loss_algorithm::maximal_heat_loss) {
+                        f(shortcut{in.to, t, workspace.witness_limit[t]});
+                        workspace.witness_limit[t] = heat_loss_algorithm::maximal_heat_loss;
+                    }
+                }
+            }
+        }
+
+        // Twice the edge difference plus the number of neighbours contracted already, which spreads the contraction
+        // evenly, plus the level, i.e. the longest chain of contracted states below v, which keeps the hierarchy flat
+        [[nodiscard]] int edge_difference_priority(index v, std::size_t shortcuts) const {
+            const auto edge_difference = static_cast<int>(shortcuts)
+                                         - static_cast<int>(out_edges[v].size() + in_edges[v].size());
+            return 2 * edge_difference + static_cast<int>(deleted_neighbors[v]) + static_cast<int>(level[v]);
+        }
+
+        int compute_priority(index v, witness_workspace &workspace) const {
+            std::size_t shortcuts = 0;
+            for_each_needed_shortcut(v, workspace, [&shortcuts](const shortcut &) { ++shortcuts; });
+            return edge_difference_priority(v, shortcuts);
+        }
+
+        void find_shortcuts(index v, witness_workspace &workspace, std::vector<shortcut> &result) const {
+            for_each_needed_shortcut(v, workspace, [&result](const shortcut &s) { result.push_back(s); });
+        }
+
+        // Moves the remaining edges of v to the upward graphs and replaces the paths through v by its shortcuts
+        void contract_node(index v, const std::vector<shortcut> &shortcuts, std::vector<edge> &upward_forward,
+                           std::vector<edge> &upward_backward) {
+            upward_forward = std::move(out_edges[v]);
+            upward_backward = std::move(in_edges[v]);
+            out_edges[v] = {};
+            in_edges[v] = {};
+            const auto detach = [this, v](std::vector<edge> &edges, index neighbor) {
+                std::erase_if(edges, [v](const edge &e) { return e.to == v; });
+                ++deleted_neighbors[neighbor];
+                ++priority[neighbor];
+                level[neighbor] = std::max(level[neighbor], level[v] + 1);
+            };
+            for (const auto &e : upward_forward) detach(in_edges[e.to], e.to);
+            for (const auto &e : upward_backward) detach(out_edges[e.to], e.to);
+            for (const auto &s : shortcuts) add_edge(s.from, s.to, s.heat_loss);
+            contracted[v] = true;
+        }
+    };
+};
+
+// Bidirectional upward search on a contraction hierarchy. Keeps its scratch space between queries and only resets
+// what the previous query touched, so that a query costs time proportional to the states it settles.
+class contraction_hierarchy_query {
+public:
+    using index = contraction_hierarchy::index;
+
+    explicit contraction_hierarchy_query(const contraction_hierarchy &hierarchy)
+            : hierarchy(hierarchy),
+              forward(hierarchy.node_count(), heat_loss_algorithm::maximal_heat_loss),
+              backward(hierarchy.node_count(), heat_loss_algorithm::maximal_heat_loss) {}
+
+    unsigned run(const heat_loss_query &query) {
+        check_position(hierarchy, query.source);
+        check_position(hierarchy, query.target);
+        check_max_count(query);
+        for (const auto i : touched) {
+            forward[i] = heat_loss_algorithm::maximal_heat_loss;
+            backward[i] = heat_loss_algorithm::maximal_heat_loss;
+        }
+        touched.clear();
+        settled_nodes = 0;
+
+        search_queue forward_queue;
+        search_queue backward_queue;
+        using state_kind = contraction_hierarchy::state_kind;
+        reach(forward, forward_queue, hierarchy.to_index(query.source, state_kind::start), 0);
+        // a path may end in the middle of a run, which is the same as a shorter run ending with a turn
+        for (const auto kind : {state_kind::horizontal, state_kind::vertical, state_kind::start}) {
+            reach(backward, backward_queue, hierarchy.to_index(query.target, kind), 0);
+        }
+
+        unsigned best = heat_loss_algorithm::maximal_heat_loss;
+        const auto meet = [&](index v) {
+            if (forward[v] != heat_loss_algorithm::maximal_heat_loss
+                && backward[v] != heat_loss_algorithm::maximal_heat_loss) {
+                best = std::min(best, forward[v] + backward[v]);
+            }
+        };
+        const auto step = [&](std::vector<unsigned> &heat_loss, search_queue &queue, bool upward_forward) {
+            const auto [current_heat_loss, current] = queue.top();
+            queue.pop();
+            if (current_heat_loss != heat_loss[current]) return;
+            ++settled_nodes;
+            meet(current);
+            const auto edges = upward_forward ? hierarchy.upward_forward(current) : hierarchy.upward_backward(current);
+            for (const auto &e : edges) {
+                reach(heat_loss, queue, e.to, current_heat_loss + e.heat_loss);
+            }
+        };
+        while (true) {
+            const bool forward_open = !forward_queue.empty() && forward_queue.top().first < best;
+            const bool backward_open = !backward_queue.empty() && backward_queue.top().first < best;
+            if (!forward_open && !backward_open) break;
+            if (forward_open && (!backward_open || forward_queue.top().first <= backward_queue.top().first)) {
+                step(forward, forward_queue, true);
+            } else {
+                step(backward, backward_queue, false);
+            }
+        }
+        return best;
+    }
+
+    // States settled by the last query, in both directions
+    std::size_t settled_nodes = 0;
+
+private:
+    using search_queue = std::priority_queue<std::pair<unsigned, index>, std::vector<std::pair<unsigned, index>>,
+                                             std::greater<>>;
+
+    const contraction_hierarchy &hierarchy;
+    std::vector<unsigned> forward;
+    std::vector<unsigned> backward;
+    std::vector<index> touched;
+
+    void reach(std::vector<unsigned> &heat_loss, search_queue &queue, index v, unsigned value) {
+        if (value < heat_loss[v]) {
+            if (forward[v] == heat_loss_algorithm::maximal_heat_loss
+                && backward[v] == heat_loss_algorithm::maximal_heat_loss) {
+                touched.push_back(v);
+            }
+            heat_loss[v] = value;
+            queue.emplace(value, v);
+        }
+    }
+};
+
+inline unsigned minimal_heat_loss(const contraction_hierarchy &hierarchy, const heat_loss_query &query) {
+    return contraction_hierarchy_query{hierarchy}.run(query);
+}
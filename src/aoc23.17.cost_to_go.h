@@ -0,0 +1,170 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+// Exact heat loss from every state to one fixed target, from a single search backwards over the state graph. Once
+// computed, queries from any source to that target are a lookup, and for targets nearby the table still gives a
+// consistent A* heuristic. It can be saved next to the map and is only loaded for the map it was computed on.
+class cost_to_go_table {
+public:
+    using position = city_map::position;
+    using node = heat_loss_state_graph::node;
+
+    static cost_to_go_table compute(const city_map &map, const position &target) {
+        check_position(map, target);
+        cost_to_go_table table{map.width(), map.height(), target};
+        // row major, so that the indices match index()
+        const basic_heat_loss_state_graph<row_major_state_layout> graph{map};
+        heat_loss_span values{table.values};
+        auto search = make_state_graph_search(graph, values, search_direction::backward);
+        graph.for_each_node_at(target, [&](const node &n) { search.reach(n, 0); });
+        search.run();
+        table.map_hash = map.content_hash();
+        return table;
+    }
+
+    [[nodiscard]] const position &target() const { return depot; }
+    [[nodiscard]] std::size_t width() const { return columns; }
+    [[nodiscard]] std::size_t height() const { return rows; }
+
+    // Throws std::runtime_error unless map is the one the table was computed for, like load(). Any other map, even
+    // one of the same size, would make the lookups wrong and the estimates inadmissible.
+    void check_map(const city_map &map) const {
+        if (map.width() != columns || map.height() != rows || map.content_hash() != map_hash) {
+            throw std::runtime_error(std::format("cost to go table of a {}x{} map does not belong to this {}x{} map",
+                                                 columns, rows, map.width(), map.height()));
+        }
+    }
+
+    // maximal_heat_loss if the target cannot be reached from n
+    [[nodiscard]] unsigned get(const node &n) const {
+        return values[index(n)];
+    }
+
+    // Heat loss of the cheapest path from source to the target
+    [[nodiscard]] unsigned from(const position &source) const {
+        check_position(*this, source);
+        return get(heat_loss_state_graph::start_node(source));
+    }
+
+    // Lower bound for the heat loss from n to another target: a path to it followed by the cheapest way on to our
+    // target cannot be cheaper than the cheapest way from n to our target. Consistent, as the table is exact.
+    // `worst_onwards` comes from worst_onwards_from() for the other target.
+    [[nodiscard]] unsigned estimate(const node &n, unsigned worst_onwards) const {
+        const auto cost = get(n);
+        if (cost == heat_loss_algorithm::maximal_heat_loss) return 0;
+        return cost > worst_onwards ? cost - worst_onwards : 0;
+    }
+
+    // The largest cost to go from any state at pos, for estimate(). If one of them cannot reach our target at all,
+    // it is maximal_heat_loss and the estimates are all zero.
+    [[nodiscard]] unsigned worst_onwards_from(const position &pos) const {
+        check_position(*this, pos);
+        unsigned worst = 0;
+        for (auto dir : heat_loss_state_graph::all_directions) {
+            for (unsigned count = 1; count <= heat_loss_state_graph::step_history::max_count; ++count) {
+                worst = std::max(worst, get(node{pos, {dir, count}}));
+            }
+        }
+        return worst;
+    }
+
+    // Binary: header with dimensions, target and the content hash of the map, then one 32 bit value per state
+    void save(std::ostream &out) const {
+        const file_header header{
+                .width = static_cast<std::uint32_t>(columns),
+                .height = static_cast<std::uint32_t>(rows),
+                .target_x = static_cast<std::uint32_t>(depot.x),
+                .target_y = static_cast<std::uint32_t>(depot.y),
+                .map_hash = map_hash,
+        };
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(values.data()),
+                  static_cast<std::streamsize>(values.size() * sizeof(unsigned)));
+        if (!out) {
+            throw std::runtime_error("could not write cost to go table");
+        }
+    }
+
+    // Throws std::runtime_error if the data is damaged or was computed for another map
+    static cost_to_go_table load(std::istream &in, const city_map &map) {
+        file_header header;
+        if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.magic != file_magic) {
+            throw std::runtime_error("not a cost to go table");
+        }
+        if (header.width != map.width() || header.height != map.height() || header.map_hash != map.content_hash()) {
+            throw std::runtime_error(std::format("cost to go table of a {}x{} map does not belong to this {}x{} map",
+                                                 header.width, header.height, map.width(), map.height()));
+        }
+        if (header.target_x >= header.width || header.target_y >= header.height) {
+            throw std::runtime_error("cost to go table with target outside of the map");
+        }
+        cost_to_go_table table{header.width, header.height, {header.target_x, header.target_y}};
+        table.map_hash = header.map_hash;
+        if (!in.read(reinterpret_cast<char *>(table.values.data()),
+                     static_cast<std::streamsize>(table.values.size() * sizeof(unsigned)))) {
+            throw std::runtime_error("truncated cost to go table");
+        }
+        return table;
+    }
+
+private:
+    static constexpr std::uint32_t file_magic = 0x54434f41; // "AOCT"
+
+    struct file_header {
+        std::uint32_t magic = file_magic;
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        std::uint32_t target_x = 0;
+        std::uint32_t target_y = 0;
+        std::uint32_t reserved = 0;
+        std::uint64_t map_hash = 0;
+    };
+
+    std::size_t columns;
+    std::size_t rows;
+    position depot;
+    std::uint64_t map_hash = 0;
+    std::vector<unsigned> values;
+
+    cost_to_go_table(std::size_t width, std::size_t height, position target)
+            : columns(width), rows(height), depot(target),
+              values(width * height * heat_loss_state_graph::states_per_cell, heat_loss_algorithm::maximal_heat_loss) {}
+
+    // Same numbering as heat_loss_state_graph, but fixed to row major so that files do not depend on the build
+    [[nodiscard]] std::size_t index(const node &n) const {
+        return ((n.pos.y * columns + n.pos.x) * heat_loss_state_graph::all_directions.size()
+                + static_cast<std::size_t>(n.history.dir)) * heat_loss_state_graph::step_history::max_count
+               + n.history.count - 1;
+    }
+
+};
+
+// A* towards query.target guided by a table for a nearby target. If the table is for the target itself, no search
+// is needed at all. Throws std::runtime_error if the table belongs to another map.
+inline unsigned minimal_heat_loss(const cost_to_go_table &table, const city_map &map, const heat_loss_query &query) {
+    using node = heat_loss_state_graph::node;
+    check_max_count(query);
+    table.check_map(map);
+    check_position(map, query.source);
+    if (query.target == table.target()) {
+        return table.from(query.source);
+    }
+    check_position(map, query.target);
+
+    const heat_loss_state_graph graph{map};
+    const auto worst_onwards = table.worst_onwards_from(query.target);
+    std::vector<unsigned> heat_loss(graph.size(), heat_loss_algorithm::maximal_heat_loss);
+    heat_loss_span best{heat_loss};
+    auto search = make_state_graph_search(graph, best, search_direction::forward,
+                                          [&](const node &n) { return table.estimate(n, worst_onwards); });
+    search.reach(heat_loss_state_graph::start_node(query.source), 0);
+    return search.run([&](const node &n, unsigned) { return n.pos == query.target; });
+}
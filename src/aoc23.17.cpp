@@ -1,2 +1,17 @@
 #include "aoc23.17.h"
-#include <iostream>
+#include "aoc23.17.alt.h"
+#include "aoc23.17.anytime.h"
+#include "aoc23.17.async.h"
+#include "aoc23.17.batch.h"
+#include "aoc23.17.cache.h"
+#include "aoc23.17.ch.h"
+#include "aoc23.17.cost_to_go.h"
+#include "aoc23.17.incremental.h"
+#include "aoc23.17.jump.h"
+#include "aoc23.17.overlay.h"
+#include "aoc23.17.packed.h"
+#include "aoc23.17.pyramid.h"
+#include "aoc23.17.relax.h"
+#include "aoc23.17.sweep.h"
+#include "aoc23.17.tiled.h"
+#include "aoc23.17.wavefront.h"
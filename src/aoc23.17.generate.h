@@ -0,0 +1,42 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <random>
+
+// Map with uniformly distributed heat loss digits, reproducible through the seed.
+inline city_map random_city_map(std::size_t width, std::size_t height, unsigned seed = 17) {
+    std::mt19937 engine{seed};
+    std::uniform_int_distribution<unsigned> digit{1, 9};
+
+    city_map map;
+    city_map::row r(width);
+    for (std::size_t y = 0; y < height; ++y) {
+        std::generate(r.begin(), r.end(), [&] { return digit(engine); });
+        map.add_row(r);
+    }
+    return map;
+}
+
+// Adversarial map for the sweep engines: cheap corridors two rows high, separated by expensive walls with a gap at
+// alternating ends, so that the cheapest paths wind back and forth through the whole map.
+inline city_map serpentine_city_map(std::size_t width, std::size_t height, unsigned corridor = 1, unsigned wall = 9) {
+    constexpr std::size_t corridor_rows = 2;
+    constexpr std::size_t gap = 2;
+
+    city_map map;
+    city_map::row r(width);
+    std::size_t walls = 0;
+    for (std::size_t y = 0; y < height; ++y) {
+        if (y % (corridor_rows + 1) != corridor_rows) {
+            std::fill(r.begin(), r.end(), corridor);
+        } else {
+            std::fill(r.begin(), r.end(), wall);
+            const auto gap_begin = walls % 2 == 0 ? width - std::min(gap, width) : 0;
+            std::fill_n(r.begin() + static_cast<std::ptrdiff_t>(gap_begin), std::min(gap, width), corridor);
+            ++walls;
+        }
+        map.add_row(r);
+    }
+    return map;
+}
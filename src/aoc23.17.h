@@ -2,33 +2,92 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <chrono>
+#include <concepts>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
 #include <format>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <optional>
 #include <queue>
 #include <ranges>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <tuple>
 #include <type_traits>
+#include <variant>
 #include <vector>
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#ifndef AOC_SOLVER_STATS
+#define AOC_SOLVER_STATS 0
+#endif
+
+#ifndef AOC_STATE_TILE_SIZE
+#define AOC_STATE_TILE_SIZE 0
+#endif
+
+enum class direction : int8_t {
+    NORTH,
+    SOUTH,
+    EAST,
+    WEST
+};
+
+constexpr direction opposite(direction dir) {
+    switch (dir) {
+        case direction::NORTH:
+            return direction::SOUTH;
+        case direction::SOUTH:
+            return direction::NORTH;
+        case direction::EAST:
+            return direction::WEST;
+        case direction::WEST:
+            return direction::EAST;
+    }
+    return direction::NORTH;
+}
+
+// The two directions a run in `dir` can turn into
+constexpr std::array<direction, 2> turns(direction dir) {
+    if (dir == direction::NORTH || dir == direction::SOUTH) {
+        return {direction::EAST, direction::WEST};
+    }
+    return {direction::NORTH, direction::SOUTH};
+}
+
 class city_map {
 public:
     using row = std::vector<unsigned>;
 
     [[nodiscard]] auto width() const {
-        return grid.empty() ? 0 : grid.front().size();
+        return columns;
     }
 
     [[nodiscard]] auto height() const {
-        return grid.size();
+        return columns == 0 ? 0 : cells.size() / columns;
     }
 
     void add_row(row r) {
-        if (!grid.empty() && r.size() != width()) {
+        if (!cells.empty() && r.size() != width()) {
             throw std::runtime_error(std::format("added row with wrong length: {} instead of {}", r.size(), width()));
         }
-        grid.emplace_back(std::move(r));
+        grid_hash += hash_row(height(), r);
+        prefix_sums = std::monostate{};
+        columns = r.size();
+        cells.insert(cells.end(), r.begin(), r.end());
     }
 
     struct position {
@@ -39,44 +98,246 @@ public:
     };
 
     [[nodiscard]] unsigned heat_loss(const position &p) const {
-        return grid.at(p.y).at(p.x);
+        return cells.at(index(p));
     }
 
+    void set_heat_loss(const position &p, unsigned value) {
+        const auto i = index(p);
+        const auto row_cells = std::span(cells).subspan(p.y * columns, columns);
+        grid_hash -= hash_row(p.y, row_cells);
+        cells[i] = value;
+        grid_hash += hash_row(p.y, row_cells);
+        prefix_sums = std::monostate{};
+    }
+
+    // Sums of the cells before each cell of its row and of its column, for segment_cost() in constant time. They
+    // take 16 bits per entry if a whole row or column fits, 32 otherwise, and are built in one pass over the rows,
+    // in which the column sums of a row are added up lane by lane. Any change of the map drops them again.
+    // No engine uses them: the jump engine and the contraction hierarchy need the heat loss after every cell of a
+    // run of at most max_count cells, one read per cell either way, and city_map_view does not carry them.
+    void build_prefix_sums() {
+        const auto largest_cell = cells.empty() ? 0u : *std::ranges::max_element(cells);
+        const auto largest_sum = std::uint64_t{largest_cell} * std::max(width(), height());
+        if (largest_sum <= std::numeric_limits<std::uint16_t>::max()) {
+            prefix_sums = make_prefix_sums<std::uint16_t>();
+        } else {
+            prefix_sums = make_prefix_sums<std::uint32_t>();
+        }
+    }
+
+    [[nodiscard]] bool has_prefix_sums() const {
+        return !std::holds_alternative<std::monostate>(prefix_sums);
+    }
+
+    [[nodiscard]] std::size_t prefix_sum_bytes() const {
+        return std::visit([]<typename Sums>(const Sums &sums) -> std::size_t {
+            if constexpr (std::is_same_v<Sums, std::monostate>) {
+                return 0;
+            } else {
+                return (sums.rows.size() + sums.columns.size()) * sizeof(typename Sums::value_type);
+            }
+        }, prefix_sums);
+    }
+
+    // Heat loss of the `length` cells a straight move from p in direction dir enters, p itself not included.
+    // Constant time with prefix sums, otherwise it adds the cells up.
+    [[nodiscard]] unsigned segment_cost(const position &p, direction dir, std::size_t length) const {
+        static_cast<void>(index(p));  // throws for a start outside the map
+        const bool inside = dir == direction::NORTH ? length <= p.y
+                          : dir == direction::SOUTH ? p.y + length < height()
+                          : dir == direction::WEST ? length <= p.x
+                          : p.x + length < width();
+        if (!inside) {
+            throw std::out_of_range(std::format("segment of {} cells from ({}, {}) leaves the {}x{} map",
+                                                length, p.x, p.y, width(), height()));
+        }
+        return std::visit([&]<typename Sums>(const Sums &sums) -> unsigned {
+            if constexpr (std::is_same_v<Sums, std::monostate>) {
+                unsigned sum = 0;
+                auto pos = p;
+                for (std::size_t i = 0; i < length; ++i) {
+                    switch (dir) {
+                        case direction::NORTH: --pos.y; break;
+                        case direction::SOUTH: ++pos.y; break;
+                        case direction::WEST: --pos.x; break;
+                        case direction::EAST: ++pos.x; break;
+                    }
+                    sum += cells[pos.y * columns + pos.x];
+                }
+                return sum;
+            } else {
+                return sums.segment(columns, p, dir, length);
+            }
+        }, prefix_sums);
+    }
+
+    // Row major cells without padding, i.e. the stride equals the width
+    [[nodiscard]] const unsigned *data() const {
+        return cells.data();
+    }
+
+    // 64 bit hash over dimensions and content. It is the sum of one hash per row, kept up to date by add_row() and
+    // set_heat_loss() at the cost of hashing one row, so reading it never writes and is safe from several threads.
+    [[nodiscard]] std::uint64_t content_hash() const {
+        return avalanche(grid_hash ^ (width() * hash_prime_1) ^ (height() * hash_prime_2));
+    }
+
+private:
+    template<typename T>
+    struct prefix_sum_table {
+        using value_type = T;
+        // per row the sums of the first 0..width() cells
+        std::vector<T> rows;
+        // per column the sums of the first 0..height() cells, row major like the map
+        std::vector<T> columns;
+
+        [[nodiscard]] unsigned segment(std::size_t width, const position &p, direction dir, std::size_t length) const {
+            const auto *row = rows.data() + p.y * (width + 1);
+            const auto column = [&](std::size_t y) { return columns[y * width + p.x]; };
+            switch (dir) {
+                case direction::NORTH:
+                    return column(p.y) - column(p.y - length);
+                case direction::SOUTH:
+                    return column(p.y + length + 1) - column(p.y + 1);
+                case direction::WEST:
+                    return row[p.x] - row[p.x - length];
+                case direction::EAST:
+                    return row[p.x + length + 1] - row[p.x + 1];
+            }
+            return 0;
+        }
+    };
+
+    std::vector<unsigned> cells;
+    std::size_t columns = 0;
+    std::uint64_t grid_hash = 0;
+    std::variant<std::monostate, prefix_sum_table<std::uint16_t>, prefix_sum_table<std::uint32_t>> prefix_sums;
+
+    template<typename T>
+    [[nodiscard]] prefix_sum_table<T> make_prefix_sums() const {
+        prefix_sum_table<T> sums;
+        sums.rows.resize(height() * (columns + 1));
+        sums.columns.assign((height() + 1) * columns, 0);
+        for (std::size_t y = 0; y < height(); ++y) {
+            const auto *cell = cells.data() + y * columns;
+            auto *row = sums.rows.data() + y * (columns + 1);
+            row[0] = 0;
+            for (std::size_t x = 0; x < columns; ++x) {
+                row[x + 1] = static_cast<T>(row[x] + cell[x]);
+            }
+            const auto *above = sums.columns.data() + y * columns;
+            auto *below = sums.columns.data() + (y + 1) * columns;
+            for (std::size_t x = 0; x < columns; ++x) {
+                below[x] = static_cast<T>(above[x] + cell[x]);
+            }
+        }
+        return sums;
+    }
+
+    [[nodiscard]] std::size_t index(const position &p) const {
+        if (p.x >= width() || p.y >= height()) {
+            throw std::out_of_range(std::format("position ({}, {}) outside of {}x{} map", p.x, p.y, width(), height()));
+        }
+        return p.y * columns + p.x;
+    }
+
+    static constexpr std::uint64_t hash_seed = 0x27d4eb2f165667c5ULL;
+    static constexpr std::uint64_t hash_prime_1 = 0x9e3779b185ebca87ULL;
+    static constexpr std::uint64_t hash_prime_2 = 0xc2b2ae3d27d4eb4fULL;
+
+    // xxHash64 style accumulation: multiply, rotate, multiply per value, seeded with the row index so that the sum
+    // over the rows still depends on their order
+    static std::uint64_t hash_row(std::size_t y, std::span<const unsigned> r) {
+        auto acc = hash_seed + y * hash_prime_1;
+        for (const auto value : r) {
+            acc = std::rotl(acc + value * hash_prime_2, 31) * hash_prime_1;
+        }
+        return std::rotl(acc, 27) * hash_prime_1 + hash_prime_2;
+    }
+
+    static std::uint64_t avalanche(std::uint64_t h) {
+        h ^= h >> 33;
+        h *= hash_prime_2;
+        h ^= h >> 29;
+        h *= hash_prime_1;
+        return h ^ (h >> 32);
+    }
+};
+
+// Non-owning, immutable window onto row major heat loss cells. Solvers only read the map through a view, so any
+// number of them can share one city_map without copying it. The map has to outlive all views onto it.
+class city_map_view {
+public:
+    using position = city_map::position;
+
+    city_map_view(const unsigned *cells, std::size_t width, std::size_t height, std::size_t stride)
+            : cells(cells), columns(width), rows(height), row_stride(stride) {}
+
+    city_map_view(const city_map &map)
+            : city_map_view(map.data(), map.width(), map.height(), map.width()) {}
+
+    [[nodiscard]] std::size_t width() const { return columns; }
+    [[nodiscard]] std::size_t height() const { return rows; }
+    [[nodiscard]] std::size_t stride() const { return row_stride; }
+
+    [[nodiscard]] unsigned heat_loss(const position &p) const {
+        return cells[p.y * row_stride + p.x];
+    }
+
+    // The width() cells of row y
+    [[nodiscard]] const unsigned *row_data(std::size_t y) const {
+        return cells + y * row_stride;
+    }
 
 private:
-    std::vector<row> grid;
+    const unsigned *cells;
+    std::size_t columns;
+    std::size_t rows;
+    std::size_t row_stride;
 };
 
-enum class direction : int8_t {
-    NORTH,
-    SOUTH,
-    EAST,
-    WEST
+// What the generic solvers need of a map. Besides city_map and city_map_view, a map can be computed on the fly, like
+// tiled_city_map, and the solvers keep it by value, so it should be as cheap to copy as a view.
+template<typename Map>
+concept heat_loss_map = requires(const Map &map, const city_map::position &pos) {
+    { map.width() } -> std::convertible_to<std::size_t>;
+    { map.height() } -> std::convertible_to<std::size_t>;
+    { map.heat_loss(pos) } -> std::convertible_to<unsigned>;
 };
 
-constexpr direction opposite(direction dir) {
+// Throws std::out_of_range unless pos lies on the map, which can be anything with a width() and a height()
+template<typename Map>
+void check_position(const Map &map, const city_map::position &pos) {
+    if (pos.x >= map.width() || pos.y >= map.height()) {
+        throw std::out_of_range(std::format("position ({}, {}) outside of {}x{} map",
+                                            pos.x, pos.y, map.width(), map.height()));
+    }
+}
+
+// The neighbour of pos in direction dir, if there is one on the map
+template<heat_loss_map Map>
+std::optional<city_map::position> step(const Map &map, city_map::position pos, direction dir) {
     switch (dir) {
         case direction::NORTH:
-            return direction::SOUTH;
+            return (pos.y == 0) ? std::nullopt : std::optional(city_map::position{pos.x, pos.y - 1});
         case direction::SOUTH:
-            return direction::NORTH;
+            return (pos.y == map.height() - 1) ? std::nullopt : std::optional(city_map::position{pos.x, pos.y + 1});
         case direction::EAST:
-            return direction::WEST;
+            return (pos.x == map.width() - 1) ? std::nullopt : std::optional(city_map::position{pos.x + 1, pos.y});
         case direction::WEST:
-            return direction::EAST;
+            return (pos.x == 0) ? std::nullopt : std::optional(city_map::position{pos.x - 1, pos.y});
     }
-    return direction::NORTH;
+    return std::nullopt;
 }
 
-
 struct heat_loss_algorithm {
-    explicit heat_loss_algorithm(city_map map)
-            : map(std::move(map)) {}
+    explicit heat_loss_algorithm(city_map_view map)
+            : map(map) {}
 
     using position = city_map::position;
     static constexpr auto maximal_heat_loss = std::numeric_limits<unsigned>::max();
     static constexpr position initial_position{0, 0};
-    city_map map;
+    city_map_view map;
 };
 
 template<typename T>
@@ -91,11 +352,18 @@ struct prio_queue {
         }
     };
 
-    std::vector<element> elements;
+    std::pmr::vector<element> elements;
+
+    prio_queue() = default;
+
+    explicit prio_queue(std::pmr::memory_resource *resource)
+            : elements(resource) {}
 
+    // Behind all elements of the same weight, so that a node added at the weight of the top, through a cell
+    // without heat loss, does not end up above it before the top is popped
     auto find_pos(Weight weight) {
         return std::lower_bound(elements.rbegin(), elements.rend(), weight,
-                                [](const element &e, Weight w) { return e.weight < w; });
+                                [](const element &e, Weight w) { return e.weight <= w; });
     }
 
     void add(T t, Weight weight) {
@@ -124,6 +392,328 @@ struct prio_queue {
 
 };
 
+// Counters and phase timings of a single solver run. They are only collected if the library is built with
+// AOC_SOLVER_STATS, otherwise all recording functions are empty and the solvers compile to the same code as
+// without them.
+struct solver_stats {
+    static constexpr bool enabled = AOC_SOLVER_STATS;
+    using counter = std::size_t solver_stats::*;
+    using phase = std::chrono::nanoseconds solver_stats::*;
+
+    std::size_t nodes_pushed = 0;
+    std::size_t nodes_popped = 0;
+    std::size_t stale_pops = 0;
+    std::size_t relaxations = 0;
+    std::size_t decreases = 0;
+    std::size_t max_queue_size = 0;
+    std::size_t peak_state_bytes = 0;
+    std::size_t upper_bound = 0;
+    std::size_t pruned = 0;
+    std::size_t heuristic_estimate = 0;
+    std::chrono::nanoseconds heuristic_time{};
+    std::chrono::nanoseconds prepare_time{};
+    std::chrono::nanoseconds search_time{};
+    std::chrono::nanoseconds extraction_time{};
+
+    void count(counter c, std::size_t amount = 1) {
+        if constexpr (enabled) {
+            this->*c += amount;
+        }
+    }
+
+    void record(counter c, std::size_t value) {
+        if constexpr (enabled) {
+            this->*c = value;
+        }
+    }
+
+    void track_max(counter c, std::size_t value) {
+        if constexpr (enabled) {
+            this->*c = std::max(this->*c, value);
+        }
+    }
+
+    template<typename F>
+    decltype(auto) time(phase p, F &&f) {
+        if constexpr (enabled) {
+            const auto start_time = std::chrono::steady_clock::now();
+            struct add_elapsed {
+                std::chrono::nanoseconds &elapsed;
+                std::chrono::steady_clock::time_point start_time;
+                ~add_elapsed() { elapsed += std::chrono::steady_clock::now() - start_time; }
+            } guard{this->*p, start_time};
+            return f();
+        } else {
+            return f();
+        }
+    }
+
+    [[nodiscard]] std::string to_json() const {
+        const auto us = [](std::chrono::nanoseconds ns) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(ns).count();
+        };
+        return std::format(R"({{"enabled": {}, "nodes_pushed": {}, "nodes_popped": {}, "stale_pops": {}, )"
+                           R"("relaxations": {}, "decreases": {}, "max_queue_size": {}, "peak_state_bytes": {}, )"
+                           R"("upper_bound": {}, "pruned": {}, "heuristic_estimate": {}, "heuristic_us": {}, )"
+                           R"("prepare_us": {}, "search_us": {}, "extraction_us": {}}})",
+                           enabled, nodes_pushed, nodes_popped, stale_pops, relaxations, decreases, max_queue_size,
+                           peak_state_bytes, upper_bound, pruned, heuristic_estimate, us(heuristic_time),
+                           us(prepare_time), us(search_time), us(extraction_time));
+    }
+};
+
+// Backing pages of the large solver tables. Huge pages save TLB misses on big maps; what the system actually
+// granted may be less than what was asked for and is reported by zeroed_buffer::obtained_pages().
+enum class page_mode {
+    standard,
+    transparent_huge, // madvise(MADV_HUGEPAGE), the kernel merges pages into huge ones where it can
+    huge_tlb,         // explicit MAP_HUGETLB pages, needs pages reserved by the administrator
+};
+
+constexpr const char *to_string(page_mode mode) {
+    switch (mode) {
+        case page_mode::standard:
+            return "standard";
+        case page_mode::transparent_huge:
+            return "transparent_huge";
+        case page_mode::huge_tlb:
+            return "huge_tlb";
+    }
+    return "unknown";
+}
+
+// Zero initialized array from calloc: large allocations come as untouched zero pages from the OS, so only the pages
+// the search actually writes to cost time and memory. With huge pages requested, the memory is mapped directly and
+// falls back from hugetlb to transparent huge pages to calloc as far as the system requires.
+template<typename T>
+class zeroed_buffer {
+    static_assert(std::is_trivial_v<T>);
+public:
+    explicit zeroed_buffer(std::size_t size, page_mode pages = page_mode::standard)
+            : data(allocate(size, pages)), count(size), capacity(size), requested(pages) {}
+
+    T &operator[](std::size_t i) { return data.get()[i]; }
+    const T &operator[](std::size_t i) const { return data.get()[i]; }
+
+    [[nodiscard]] std::size_t size() const { return count; }
+
+    [[nodiscard]] page_mode obtained_pages() const { return data.get_deleter().pages; }
+
+    // Zeroes the buffer for reuse with a new size, only allocating if it has to grow
+    void clear(std::size_t size) {
+        if (size > capacity) {
+            data.reset();
+            data = allocate(size, requested);
+            capacity = size;
+        } else if (!discard_pages(size)) {
+            std::memset(data.get(), 0, size * sizeof(T));
+        }
+        count = size;
+    }
+
+private:
+    static constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+
+    struct release {
+        page_mode pages = page_mode::standard;
+        std::size_t bytes = 0;
+
+        void operator()(T *p) const {
+#ifdef __linux__
+            if (pages != page_mode::standard) {
+                ::munmap(p, bytes);
+                return;
+            }
+#endif
+            std::free(p);
+        }
+    };
+    using pointer = std::unique_ptr<T[], release>;
+
+    pointer data;
+    std::size_t count;
+    std::size_t capacity;
+    page_mode requested;
+
+    static pointer allocate(std::size_t size, page_mode pages) {
+#ifdef __linux__
+        // below one huge page there is nothing to gain
+        const bool large = size * sizeof(T) >= huge_page_size;
+        const auto bytes = (size * sizeof(T) + huge_page_size - 1) / huge_page_size * huge_page_size;
+        if (pages == page_mode::huge_tlb && large) {
+            void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                return pointer{static_cast<T *>(p), release{page_mode::huge_tlb, bytes}};
+            }
+            pages = page_mode::transparent_huge;
+        }
+        if (pages == page_mode::transparent_huge && large) {
+            void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p != MAP_FAILED) {
+                if (::madvise(p, bytes, MADV_HUGEPAGE) == 0) {
+                    return pointer{static_cast<T *>(p), release{page_mode::transparent_huge, bytes}};
+                }
+                ::munmap(p, bytes);
+            }
+        }
+#endif
+        auto *p = static_cast<T *>(std::calloc(size, sizeof(T)));
+        if (p == nullptr && size != 0) {
+            throw std::bad_alloc{};
+        }
+        return pointer{p, release{}};
+    }
+
+    // Mapped memory is zeroed by handing the pages back, which also keeps untouched pages free
+    bool discard_pages([[maybe_unused]] std::size_t size) {
+#ifdef __linux__
+        if (obtained_pages() == page_mode::transparent_huge) {
+            return ::madvise(data.get(), data.get_deleter().bytes, MADV_DONTNEED) == 0;
+        }
+#endif
+        return false;
+    }
+};
+
+// Heat loss per state on top of a zeroed_buffer. Values are stored offset by one so that the zero pages read as
+// maximal_heat_loss, i.e. not reached yet.
+class lazy_heat_loss_table {
+public:
+    explicit lazy_heat_loss_table(std::size_t size, page_mode pages = page_mode::standard)
+            : values(size, pages) {}
+
+    [[nodiscard]] unsigned get(std::size_t i) const {
+        return values[i] - 1;
+    }
+
+    void set(std::size_t i, unsigned heat_loss) {
+        values[i] = heat_loss + 1;
+    }
+
+    [[nodiscard]] std::size_t size() const { return values.size(); }
+
+    [[nodiscard]] page_mode obtained_pages() const { return values.obtained_pages(); }
+
+    void clear(std::size_t size) { values.clear(size); }
+
+    // back to not reached yet
+    void reset(std::size_t i) { values[i] = 0; }
+
+private:
+    zeroed_buffer<unsigned> values;
+};
+
+// Bump allocator for the transient containers of a query. Deallocation does nothing and reset() makes all memory
+// available again in O(1). Blocks added because a query outgrew the arena are merged into one on the next reset, so
+// a solver answering similar queries soon stops allocating altogether.
+class query_arena : public std::pmr::memory_resource {
+public:
+    query_arena() = default;
+    query_arena(const query_arena &) = delete;
+    query_arena &operator=(const query_arena &) = delete;
+
+    void reset() {
+        if (blocks.size() > 1) {
+            const auto total = capacity();
+            blocks.clear();
+            blocks.push_back(make_block(total));
+        }
+        used = 0;
+    }
+
+    [[nodiscard]] std::size_t capacity() const {
+        std::size_t total = 0;
+        for (const auto &b : blocks) total += b.size;
+        return total;
+    }
+
+private:
+    struct block {
+        std::unique_ptr<std::byte[]> memory;
+        std::size_t size;
+    };
+    // allocations are served from the last block
+    std::vector<block> blocks;
+    std::size_t used = 0;
+
+    static block make_block(std::size_t size) {
+        return block{std::make_unique_for_overwrite<std::byte[]>(size), size};
+    }
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (!blocks.empty()) {
+            auto &current = blocks.back();
+            void *p = current.memory.get() + used;
+            auto space = current.size - used;
+            if (std::align(alignment, bytes, p, space)) {
+                used = current.size - space + bytes;
+                return p;
+            }
+        }
+        blocks.push_back(make_block(std::max(bytes + alignment, 2 * capacity())));
+        used = 0;
+        return do_allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *, std::size_t, std::size_t) override {}
+
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Numbering of the cells in the per-state tables, all states of a cell are adjacent. Row major puts the cell
+// above a state a whole row of states away, which on wide maps means a cache miss for every vertical step.
+struct row_major_state_layout {
+    using position = city_map::position;
+    static constexpr std::size_t tile_size = 0;
+
+    [[nodiscard]] static std::size_t cells(const heat_loss_map auto &map) {
+        return map.width() * map.height();
+    }
+
+    [[nodiscard]] static std::size_t cell_index(const heat_loss_map auto &map, const position &pos) {
+        return pos.y * map.width() + pos.x;
+    }
+
+    [[nodiscard]] static position cell_position(const heat_loss_map auto &map, std::size_t i) {
+        return {i % map.width(), i / map.width()};
+    }
+};
+
+// Square tiles of TileSize x TileSize cells stored one after the other, row major within and between tiles, so
+// that the states around a cell mostly share its cache lines and pages. The map is padded to whole tiles.
+template<std::size_t TileSize>
+struct tiled_state_layout {
+    static_assert(std::has_single_bit(TileSize), "the tile size has to be a power of two");
+    using position = city_map::position;
+    static constexpr std::size_t tile_size = TileSize;
+    static constexpr std::size_t tile_cells = TileSize * TileSize;
+
+    [[nodiscard]] static std::size_t tiles_per_row(const heat_loss_map auto &map) {
+        return (map.width() + TileSize - 1) / TileSize;
+    }
+
+    [[nodiscard]] static std::size_t cells(const heat_loss_map auto &map) {
+        return tiles_per_row(map) * ((map.height() + TileSize - 1) / TileSize) * tile_cells;
+    }
+
+    [[nodiscard]] static std::size_t cell_index(const heat_loss_map auto &map, const position &pos) {
+        return ((pos.y / TileSize) * tiles_per_row(map) + pos.x / TileSize) * tile_cells
+               + (pos.y % TileSize) * TileSize + pos.x % TileSize;
+    }
+
+    [[nodiscard]] static position cell_position(const heat_loss_map auto &map, std::size_t i) {
+        const auto tile = i / tile_cells;
+        const auto in_tile = i % tile_cells;
+        return {(tile % tiles_per_row(map)) * TileSize + in_tile % TileSize,
+                (tile / tiles_per_row(map)) * TileSize + in_tile / TileSize};
+    }
+};
+
+// Chosen at build time through AOC_STATE_TILE_SIZE, 0 means row major
+using state_layout = std::conditional_t<AOC_STATE_TILE_SIZE == 0, row_major_state_layout,
+                                        tiled_state_layout<AOC_STATE_TILE_SIZE == 0 ? 1 : AOC_STATE_TILE_SIZE>>;
 
 struct heat_loss_algorithm_dijkstra : heat_loss_algorithm {
     struct step_history {
@@ -142,72 +732,111 @@ struct heat_loss_algorithm_dijkstra : heat_loss_algorithm {
         constexpr auto operator<=>(const node&) const = default;
     };
 
-    prio_queue<node> queue;
-    std::map<node, unsigned> heat_loss;
-    std::map<node, bool> visited;
+    static constexpr node initial_node{initial_position, step_history{direction::NORTH, 1}};
+    static constexpr std::size_t states_per_cell = 4 * step_history::max_count;
+
+    position source;
+    // transient memory of the current query, the queue draws from it
+    query_arena arena;
+    prio_queue<node> queue{&arena};
+    std::vector<node> next_nodes;
+    lazy_heat_loss_table heat_loss;
+    zeroed_buffer<bool> visited;
+    // see prune_above()
+    unsigned upper_bound = maximal_heat_loss;
+    position bound_target{};
+    unsigned minimal_cell_heat_loss = 0;
+    mutable solver_stats stats;
 
-    explicit heat_loss_algorithm_dijkstra(city_map map)
-            : heat_loss_algorithm(std::move(map)) {
-        prepare_nodes();
+    explicit heat_loss_algorithm_dijkstra(city_map_view map, position source = initial_position,
+                                          page_mode pages = page_mode::standard)
+            : heat_loss_algorithm(map),
+              source(source),
+              heat_loss(state_layout::cells(map) * states_per_cell, pages),
+              visited(heat_loss.size(), pages) {
+        next_nodes.reserve(4);
+        check_position(map, source);
+        stats.time(&solver_stats::prepare_time, [this] { prepare_nodes(); });
+        track_memory();
     }
 
-    bool is_valid_history(const step_history history, const position pos) {
-        if (pos == initial_position) {
-            return history.dir == direction::EAST && history.count == 1;
-        }
-        if (history.dir == direction::NORTH) {
-            return pos.y + history.count < map.height();
-        }
-        if (history.dir == direction::WEST) {
-            return pos.x + history.count < map.width();
-        }
-        if (history.dir == direction::SOUTH) {
-            return pos.y >= history.count;
-        }
-        return pos.x >= history.count;
+    // the solver only keeps a view, so it must not be handed a temporary map
+    explicit heat_loss_algorithm_dijkstra(city_map &&, position = initial_position, page_mode = page_mode::standard)
+            = delete;
+
+    // Prepares another search, possibly on a different map, reusing the memory of the state tables and the queue
+    void reset(city_map_view new_map, position new_source = initial_position) {
+        map = new_map;
+        source = new_source;
+        check_position(map, source);
+        upper_bound = maximal_heat_loss;
+        stats = {};
+        stats.time(&solver_stats::prepare_time, [this] {
+            // the queue of the last query had the right size, start with it to avoid regrowing
+            const auto previous_capacity = queue.elements.capacity();
+            queue.elements = std::pmr::vector<prio_queue<node>::element>(&arena);
+            arena.reset();
+            queue.elements.reserve(previous_capacity);
+            heat_loss.clear(state_layout::cells(map) * states_per_cell);
+            visited.clear(heat_loss.size());
+            prepare_nodes();
+        });
+        track_memory();
+    }
+
+    // The weaker of the page modes the state tables got
+    [[nodiscard]] page_mode obtained_pages() const {
+        return std::min(heat_loss.obtained_pages(), visited.obtained_pages());
+    }
+
+    // The search starts at the source as if it had just moved north, like at the top left corner of the puzzle
+    [[nodiscard]] node start_node() const {
+        return node{source, initial_node.history};
+    }
+
+    [[nodiscard]] std::size_t to_index(const node &n) const {
+        return (state_layout::cell_index(map, n.pos) * 4 + static_cast<std::size_t>(n.history.dir))
+               * step_history::max_count + n.history.count - 1;
     }
 
     void add_node(const node n, const unsigned hl) {
+        stats.count(&solver_stats::nodes_pushed);
         queue.add(n, hl);
-        heat_loss[n] = hl;
-        visited[n] = false;
+        heat_loss.set(to_index(n), hl);
     }
 
-    void prepare_nodes() {
-        add_node(node{initial_position, step_history{direction::NORTH, 1}}, 0);
-        for (unsigned x = 0; x < map.width(); ++x) {
-            for (unsigned y = 0; y < map.height(); ++y) {
-                const position pos{x, y};
-                for (direction dir: {direction::NORTH, direction::SOUTH, direction::WEST, direction::EAST}) {
-                    for (unsigned count: {1, 2, 3}) {
-                        const auto history = step_history{dir, count};
-                        if (is_valid_history(history, pos)) {
-                            add_node(node{pos,history}, maximal_heat_loss);
-                        }
-                    }
-                }
+    // Promises that some path to `target` has at most `bound` heat loss: nodes that cannot lead to the target within
+    // it, judged by the heat loss so far plus a lower bound for the rest, are then never pushed. Only the answer for
+    // `target` stays exact.
+    void prune_above(unsigned bound, const position &target) {
+        check_position(map, target);
+        upper_bound = bound;
+        bound_target = target;
+        minimal_cell_heat_loss = maximal_heat_loss;
+        for (std::size_t y = 0; y < map.height(); ++y) {
+            for (std::size_t x = 0; x < map.width(); ++x) {
+                minimal_cell_heat_loss = std::min(minimal_cell_heat_loss, map.heat_loss({x, y}));
             }
         }
+        stats.record(&solver_stats::upper_bound, bound);
     }
 
-    std::optional<position> neighbor_pos(position pos, direction dir) {
-        switch (dir) {
-            case direction::NORTH:
-                return (pos.y == 0) ? std::nullopt : std::optional(position{pos.x, pos.y-1});
-            case direction::SOUTH:
-                return (pos.y == map.height()-1) ? std::nullopt : std::optional(position{pos.x, pos.y+1});
-            case direction::EAST:
-                return (pos.x == map.width()-1) ? std::nullopt : std::optional(position{pos.x+1, pos.y});
-            case direction::WEST:
-                return (pos.x == 0) ? std::nullopt : std::optional(position{pos.x-1, pos.y});
-        }
-        return std::nullopt;
+    // Every step enters a new cell, so at least the Manhattan distance times the cheapest cell is still to come
+    [[nodiscard]] unsigned remaining_estimate(const position &pos) const {
+        const auto dx = pos.x > bound_target.x ? pos.x - bound_target.x : bound_target.x - pos.x;
+        const auto dy = pos.y > bound_target.y ? pos.y - bound_target.y : bound_target.y - pos.y;
+        return static_cast<unsigned>(dx + dy) * minimal_cell_heat_loss;
     }
 
+    // Only the origin is known up front, all other nodes are added when the search first reaches them.
+    void prepare_nodes() {
+        add_node(start_node(), 0);
+    }
+
+
     auto& neighbors(const node& n)
     {
-        thread_local std::vector<node> nodes;
-        nodes.resize(0);
+        next_nodes.resize(0);
 
         const auto last_dir = n.history.dir;
         for (auto new_dir: {direction::NORTH, direction::SOUTH, direction::WEST, direction::EAST}) {
@@ -219,57 +848,429 @@ struct heat_loss_algorithm_dijkstra : heat_loss_algorithm {
                 else new_history.count += n.history.count;
             }
 
-            const auto new_position = neighbor_pos(n.pos, new_dir);
+            const auto new_position = step(map, n.pos, new_dir);
 
             if (new_position.has_value()) {
                 const auto neighbor = node{new_position.value(), new_history};
-                if (!visited[neighbor]) {
-                    nodes.emplace_back(new_position.value(), new_history);
+                if (!visited[to_index(neighbor)]) {
+                    next_nodes.emplace_back(new_position.value(), new_history);
                 }
             }
         }
-        return nodes;
+        return next_nodes;
     }
 
+    struct never_interrupted {
+        constexpr bool operator()() const { return false; }
+    };
+    static constexpr std::size_t interrupt_check_interval = 1024;
+
     void run_dijkstra() {
-        const auto start_time = std::chrono::steady_clock::now();
+        run_dijkstra(never_interrupted{});
+    }
 
-        while (!queue.empty()) {
-            const auto [current_weight, current_node] = queue.top();
+    // Polls `interrupted` every interrupt_check_interval nodes and stops the search as soon as it returns true.
+    // Returns whether the search ran to completion.
+    template<typename Interrupted>
+    bool run_dijkstra(Interrupted &&interrupted) {
+        constexpr bool interruptible = !std::is_same_v<std::remove_cvref_t<Interrupted>, never_interrupted>;
+        const auto completed = stats.time(&solver_stats::search_time, [this, &interrupted] {
+            [[maybe_unused]] std::size_t until_check = interrupt_check_interval;
+            while (!queue.empty()) {
+                if constexpr (interruptible) {
+                    if (--until_check == 0) {
+                        until_check = interrupt_check_interval;
+                        if (interrupted()) return false;
+                    }
+                }
+                const auto [current_weight, current_node] = queue.top();
+                stats.count(&solver_stats::nodes_popped);
 
-            for (const auto& next_node : neighbors(current_node)) {
-                const auto tentative_heat_loss = heat_loss[current_node] + map.heat_loss(next_node.pos);
-                if (tentative_heat_loss < heat_loss[next_node]) {
-                    heat_loss[next_node] = tentative_heat_loss;
-                    queue.reduceWeight(next_node, tentative_heat_loss);
+                for (const auto& next_node : neighbors(current_node)) {
+                    stats.count(&solver_stats::relaxations);
+                    const auto next_index = to_index(next_node);
+                    const auto tentative_heat_loss = current_weight + map.heat_loss(next_node.pos);
+                    const auto next_heat_loss = heat_loss.get(next_index);
+                    if (tentative_heat_loss < next_heat_loss) {
+                        if (upper_bound != maximal_heat_loss
+                            && tentative_heat_loss + remaining_estimate(next_node.pos) > upper_bound) {
+                            stats.count(&solver_stats::pruned);
+                            continue;
+                        }
+                        stats.count(&solver_stats::decreases);
+                        if (next_heat_loss == maximal_heat_loss) {
+                            add_node(next_node, tentative_heat_loss);
+                        } else {
+                            heat_loss.set(next_index, tentative_heat_loss);
+                            queue.reduceWeight(next_node, tentative_heat_loss);
+                        }
+                    }
                 }
+                stats.track_max(&solver_stats::max_queue_size, queue.elements.size());
+
+                queue.pop();
+                visited[to_index(current_node)] = true;
             }
+            return true;
+        });
+        track_memory();
+        return completed;
+    }
 
-            queue.pop();
-            visited[current_node] = true;
+    [[nodiscard]] auto get_minimal_heat_loss() const {
+        return get_minimal_heat_loss(position{map.width()-1, map.height()-1});
+    }
+
+    [[nodiscard]] unsigned get_minimal_heat_loss(const position &target) const {
+        check_position(map, target);
+        return stats.time(&solver_stats::extraction_time, [this, &target] {
+            unsigned minimal_heat_loss = maximal_heat_loss;
+            for (direction dir : {direction::NORTH, direction::SOUTH, direction::WEST, direction::EAST}) {
+                for (unsigned count : {1,2,3}) {
+                    minimal_heat_loss = std::min(minimal_heat_loss, heat_loss.get(to_index(node{target, step_history{dir, count}})));
+                }
+            }
+            return minimal_heat_loss;
+        });
+    }
+
+    // Address space of the state tables (only touched pages are backed) plus the queue buffer
+    void track_memory() {
+        stats.track_max(&solver_stats::max_queue_size, queue.elements.size());
+        stats.track_max(&solver_stats::peak_state_bytes,
+                        heat_loss.size() * (sizeof(unsigned) + sizeof(bool))
+                        + queue.elements.capacity() * sizeof(prio_queue<node>::element));
+    }
+};
+
+// The (position, direction, count) state graph below heat_loss_algorithm_dijkstra as a reusable building block for
+// the other engines: dense state indices for per-state tables and the edges in both directions. The map can be any
+// heat_loss_map, the engines built on the graph default to city_map_view.
+template<typename Layout, heat_loss_map Map = city_map_view>
+struct basic_heat_loss_state_graph {
+    using layout = Layout;
+    using position = city_map::position;
+    using step_history = heat_loss_algorithm_dijkstra::step_history;
+    using node = heat_loss_algorithm_dijkstra::node;
+    using index = std::size_t;
+
+    static constexpr std::array all_directions{direction::NORTH, direction::SOUTH, direction::WEST, direction::EAST};
+    static constexpr std::size_t states_per_cell = heat_loss_algorithm_dijkstra::states_per_cell;
+
+    Map map;
+
+    [[nodiscard]] std::size_t size() const {
+        return Layout::cells(map) * states_per_cell;
+    }
+
+    [[nodiscard]] static node start_node(const position &source) {
+        return node{source, heat_loss_algorithm_dijkstra::initial_node.history};
+    }
+
+    [[nodiscard]] index to_index(const node &n) const {
+        return (Layout::cell_index(map, n.pos) * all_directions.size() + static_cast<std::size_t>(n.history.dir))
+                * step_history::max_count + n.history.count - 1;
+    }
+
+    [[nodiscard]] node to_node(index i) const {
+        const auto count = static_cast<unsigned>(i % step_history::max_count) + 1;
+        i /= step_history::max_count;
+        const auto dir = static_cast<direction>(i % all_directions.size());
+        i /= all_directions.size();
+        return node{Layout::cell_position(map, i), step_history{dir, count}};
+    }
+
+
+    template<typename F>
+    void for_each_successor(const node &n, F &&f) const {
+        for (auto new_dir : all_directions) {
+            if (new_dir == opposite(n.history.dir)) continue;
+
+            step_history new_history{new_dir, 1};
+            if (new_dir == n.history.dir) {
+                if (n.history.count == step_history::max_count) continue;
+                new_history.count += n.history.count;
+            }
+
+            if (const auto new_position = step(map, n.pos, new_dir)) {
+                f(node{*new_position, new_history});
+            }
         }
+    }
+
+    template<typename F>
+    void for_each_predecessor(const node &n, F &&f) const {
+        const auto previous_position = step(map, n.pos, opposite(n.history.dir));
+        if (!previous_position) return;
 
-        std::cerr << std::format("run time: {}", std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now() - start_time));
+        if (n.history.count > 1) {
+            f(node{*previous_position, step_history{n.history.dir, n.history.count - 1}});
+            return;
+        }
+        for (auto previous_dir : all_directions) {
+            if (previous_dir == n.history.dir || previous_dir == opposite(n.history.dir)) continue;
+            for (unsigned count = 1; count <= step_history::max_count; ++count) {
+                f(node{*previous_position, step_history{previous_dir, count}});
+            }
+        }
     }
 
-    [[nodiscard]] auto get_minimal_heat_loss() const {
-        position end = {map.width()-1, map.height()-1};
+    // All states located at a cell, i.e. all ways of having entered it
+    template<typename F>
+    void for_each_node_at(const position &pos, F &&f) const {
+        for (auto dir : all_directions) {
+            for (unsigned count = 1; count <= step_history::max_count; ++count) {
+                f(node{pos, step_history{dir, count}});
+            }
+        }
+    }
+};
+
+using heat_loss_state_graph = basic_heat_loss_state_graph<state_layout>;
+
+// get() and set() on the heat losses of a plain array, as the table of a state_graph_search
+class heat_loss_span {
+public:
+    explicit heat_loss_span(std::span<unsigned> values)
+            : values(values) {}
+
+    [[nodiscard]] unsigned get(std::size_t i) const { return values[i]; }
+    void set(std::size_t i, unsigned heat_loss) { values[i] = heat_loss; }
+
+private:
+    std::span<unsigned> values;
+};
+
+enum class search_direction {
+    forward,  // along the steps, from the seeds to the states
+    backward, // against the steps, from the states to the seeds
+};
 
-        unsigned minimal_heat_loss = maximal_heat_loss;
-        for (direction dir : {direction::SOUTH, direction::EAST}) {
-            for (unsigned count : {1,2,3}) {
-                minimal_heat_loss = std::min(minimal_heat_loss, heat_loss.at(node{end, step_history{dir, count}}));
+// Dijkstra over a state graph, or A* with a consistent estimate of the heat loss still to come, shared by the engines
+// and tables that search the graph. Every step costs the heat loss of the cell it enters, in either direction. The
+// best heat losses go to the table, anything with get(i) and set(i, value) for the state indices of the graph, where
+// maximal_heat_loss means not reached yet. The search can be confined to the states `within` accepts; the steps
+// leaving them are reported instead of taken.
+template<typename Graph, typename Table, typename Estimate, typename Within>
+class state_graph_search {
+public:
+    using position = city_map::position;
+    using node = typename Graph::node;
+    using index = typename Graph::index;
+
+    state_graph_search(const Graph &graph, Table &heat_loss, search_direction direction, Estimate estimate,
+                       Within within)
+            : graph(graph), heat_loss(heat_loss), direction(direction), estimate(std::move(estimate)),
+              within(std::move(within)) {}
+
+    // Counts pushes, pops and relaxations in these stats from now on
+    void count_in(solver_stats &s) { stats = &s; }
+
+    // Reaches n with heat_loss, unless it has been reached more cheaply already. Seeds the search, too.
+    void reach(const node &n, unsigned value) {
+        const auto i = graph.to_index(n);
+        if (value < heat_loss.get(i)) {
+            count(&solver_stats::decreases);
+            count(&solver_stats::nodes_pushed);
+            heat_loss.set(i, value);
+            queue.emplace(value + estimate(n), value, i);
+        }
+    }
+
+    // Settles the states in order until the queue runs empty or on_settle(state, heat_loss) returns true, and then
+    // returns the heat loss of that state, maximal_heat_loss if it ran empty. on_leave(state, heat_loss) gets the
+    // steps to states outside, with the heat loss before the step.
+    template<typename Settle, typename Leave>
+    unsigned run(Settle &&on_settle, Leave &&on_leave) {
+        while (!queue.empty()) {
+            const auto [priority, current_heat_loss, current_index] = queue.top();
+            queue.pop();
+            if (current_heat_loss != heat_loss.get(current_index)) {
+                count(&solver_stats::stale_pops);
+                continue;
+            }
+            count(&solver_stats::nodes_popped);
+
+            const auto current = graph.to_node(current_index);
+            if constexpr (std::is_void_v<std::invoke_result_t<Settle &, const node &, unsigned>>) {
+                on_settle(current, current_heat_loss);
+            } else if (on_settle(current, current_heat_loss)) {
+                return current_heat_loss;
             }
+            const auto relax = [&](const node &other, const position &entered) {
+                count(&solver_stats::relaxations);
+                if (!within(other)) {
+                    on_leave(other, current_heat_loss);
+                    return;
+                }
+                reach(other, current_heat_loss + graph.map.heat_loss(entered));
+            };
+            if (direction == search_direction::forward) {
+                graph.for_each_successor(current, [&](const node &next) { relax(next, next.pos); });
+            } else {
+                graph.for_each_predecessor(current, [&](const node &previous) { relax(previous, current.pos); });
+            }
+            if constexpr (solver_stats::enabled) {
+                if (stats) stats->track_max(&solver_stats::max_queue_size, queue.size());
+            }
+        }
+        return heat_loss_algorithm::maximal_heat_loss;
+    }
+
+    template<typename Settle>
+    unsigned run(Settle &&on_settle) {
+        return run(std::forward<Settle>(on_settle), [](const node &, unsigned) {});
+    }
+
+    // Settles all states that can be reached
+    void run() {
+        run([](const node &, unsigned) {});
+    }
+
+    // Whether states are still queued, e.g. after run() stopped early
+    [[nodiscard]] bool empty() const { return queue.empty(); }
+
+    // Forgets the queued states, the table is left to the caller
+    void clear() { queue = {}; }
+
+private:
+    // priority, heat loss, state
+    using entry = std::tuple<unsigned, unsigned, index>;
+
+    Graph graph;
+    Table &heat_loss;
+    search_direction direction;
+    Estimate estimate;
+    Within within;
+    std::priority_queue<entry, std::vector<entry>, std::greater<>> queue;
+    solver_stats *stats = nullptr;
+
+    void count(solver_stats::counter c) {
+        if constexpr (solver_stats::enabled) {
+            if (stats) stats->count(c);
         }
-        return minimal_heat_loss;
     }
 };
 
-inline unsigned minimal_heat_loss(const city_map &map) {
-    heat_loss_algorithm_dijkstra algorithm{map};
+template<typename Graph, typename Table, typename Estimate, typename Within>
+auto make_state_graph_search(const Graph &graph, Table &heat_loss, search_direction direction, Estimate estimate,
+                             Within within) {
+    return state_graph_search<Graph, Table, Estimate, Within>(graph, heat_loss, direction, std::move(estimate),
+                                                              std::move(within));
+}
+
+// A* over the whole graph
+template<typename Graph, typename Table, typename Estimate>
+auto make_state_graph_search(const Graph &graph, Table &heat_loss, search_direction direction, Estimate estimate) {
+    return make_state_graph_search(graph, heat_loss, direction, std::move(estimate),
+                                   [](const typename Graph::node &) { return true; });
+}
+
+// Dijkstra over the whole graph
+template<typename Graph, typename Table>
+auto make_state_graph_search(const Graph &graph, Table &heat_loss,
+                             search_direction direction = search_direction::forward) {
+    return make_state_graph_search(graph, heat_loss, direction, [](const typename Graph::node &) { return 0u; });
+}
+
+struct heat_loss_query {
+    using position = city_map::position;
+
+    position source = heat_loss_algorithm::initial_position;
+    position target;
+    unsigned max_count = heat_loss_algorithm_dijkstra::step_history::max_count;
+
+    auto operator<=>(const heat_loss_query &) const = default;
+
+    // The query minimal_heat_loss() answers: from the top left to the bottom right corner
+    static heat_loss_query whole_map(const heat_loss_map auto &map) {
+        return heat_loss_query{.target = {map.width()-1, map.height()-1}};
+    }
+};
+
+// Throws std::invalid_argument unless query.max_count is the maximal run length of the puzzle, the only one the
+// engines solve for
+inline void check_max_count(const heat_loss_query &query) {
+    if (query.max_count != heat_loss_algorithm_dijkstra::step_history::max_count) {
+        throw std::invalid_argument(std::format("unsupported maximal run length {}", query.max_count));
+    }
+}
+
+// Heat loss of the best path that only ever steps towards the target, respecting the maximal run length and the
+// start facing north. Such a path exists on most maps and is found by one pass over the rectangle between source and
+// target, which makes it a cheap upper bound for the exact search. maximal_heat_loss if there is none.
+inline unsigned staircase_upper_bound(city_map_view map, const heat_loss_query &query,
+                                      std::pmr::memory_resource *resource = std::pmr::get_default_resource()) {
+    using position = city_map::position;
+    constexpr auto infinite = heat_loss_algorithm::maximal_heat_loss;
+    constexpr std::size_t max_count = heat_loss_algorithm_dijkstra::step_history::max_count;
+
+    const std::size_t columns = (query.source.x > query.target.x ? query.source.x - query.target.x
+                                                                 : query.target.x - query.source.x) + 1;
+    const std::size_t rows = (query.source.y > query.target.y ? query.source.y - query.target.y
+                                                              : query.target.y - query.source.y) + 1;
+    if (columns == 1 && rows == 1) {
+        return 0;
+    }
+    const auto cell = [&](std::size_t i, std::size_t j) {
+        return map.heat_loss(position{query.source.x > query.target.x ? query.source.x - i : query.source.x + i,
+                                      query.source.y > query.target.y ? query.source.y - j : query.source.y + j});
+    };
+    // Having started facing north, the first step may continue that run only if the target lies to the north
+    const bool vertical_continues_start = query.target.y < query.source.y;
+
+    // per cell of a row: the run so far was horizontal or vertical, of length 1..max_count
+    using run_costs = std::array<unsigned, 2 * max_count>;
+    const auto add = [](unsigned a, unsigned b) { return a == infinite ? infinite : a + b; };
+    run_costs unreachable;
+    unreachable.fill(infinite);
+    std::pmr::vector<run_costs> previous(columns, unreachable, resource), current(columns, unreachable, resource);
+    for (std::size_t j = 0; j < rows; ++j) {
+        for (std::size_t i = 0; i < columns; ++i) {
+            auto &costs = current[i];
+            costs.fill(infinite);
+            if (i == 0 && j == 0) continue;
+
+            const auto w = cell(i, j);
+            if (i > 0) {
+                const auto &left = current[i - 1];
+                costs[0] = add(*std::ranges::min_element(left.begin() + max_count, left.end()), w);
+                for (std::size_t c = 1; c < max_count; ++c) costs[c] = add(left[c - 1], w);
+                if (i == 1 && j == 0) costs[0] = w;
+            }
+            if (j > 0) {
+                const auto &above = previous[i];
+                costs[max_count] = add(*std::ranges::min_element(above.begin(), above.begin() + max_count), w);
+                for (std::size_t c = 1; c < max_count; ++c) costs[max_count + c] = add(above[max_count + c - 1], w);
+                if (i == 0 && j == 1 && vertical_continues_start) costs[max_count + 1] = w;
+            }
+        }
+        std::swap(previous, current);
+    }
+    return *std::ranges::min_element(previous[columns - 1]);
+}
+
+// Runs the search of an algorithm that was constructed or reset for query.source, pruned by the staircase bound.
+// For callers that keep the algorithm, to reuse its memory or to read its stats afterwards.
+inline unsigned minimal_heat_loss(heat_loss_algorithm_dijkstra &algorithm, const heat_loss_query &query) {
+    check_max_count(query);
+    if (query.source != algorithm.source) {
+        throw std::invalid_argument(std::format("query from ({}, {}) to an algorithm prepared for ({}, {})",
+                                                query.source.x, query.source.y, algorithm.source.x, algorithm.source.y));
+    }
+    check_position(algorithm.map, query.target);
+    algorithm.prune_above(staircase_upper_bound(algorithm.map, query, &algorithm.arena), query.target);
     algorithm.run_dijkstra();
 
-    return algorithm.get_minimal_heat_loss();
+    return algorithm.get_minimal_heat_loss(query.target);
 }
 
+inline unsigned minimal_heat_loss(city_map_view map, const heat_loss_query &query) {
+    check_max_count(query);
+    heat_loss_algorithm_dijkstra algorithm{map, query.source};
+    return minimal_heat_loss(algorithm, query);
+}
+
+inline unsigned minimal_heat_loss(city_map_view map) {
+    return minimal_heat_loss(map, heat_loss_query::whole_map(map));
+}
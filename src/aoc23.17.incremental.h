@@ -0,0 +1,180 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <array>
+#include <functional>
+#include <map>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// Keeps the full distance table of a solved map around, so that a few changed cells only need a local repair
+// instead of a complete re-solve. Changes are collected with set_heat_loss() and applied on the next query.
+// Unlike the other solvers it owns its copy of the map, because it has to modify it.
+struct heat_loss_algorithm_incremental {
+    using position = city_map::position;
+    using step_history = heat_loss_state_graph::step_history;
+    using node = heat_loss_state_graph::node;
+    using index = heat_loss_state_graph::index;
+
+    static constexpr auto maximal_heat_loss = heat_loss_algorithm::maximal_heat_loss;
+    static constexpr auto initial_position = heat_loss_algorithm::initial_position;
+
+    static constexpr node initial_node = heat_loss_algorithm_dijkstra::initial_node;
+
+    city_map map;
+    heat_loss_state_graph graph{map};
+    std::vector<unsigned> heat_loss;
+    std::map<position, unsigned> pending_updates;
+    std::size_t repaired_nodes = 0;
+
+    explicit heat_loss_algorithm_incremental(city_map map)
+            : map(std::move(map)) {
+        solve();
+    }
+
+    // the graph views the own map
+    heat_loss_algorithm_incremental(const heat_loss_algorithm_incremental &) = delete;
+    heat_loss_algorithm_incremental &operator=(const heat_loss_algorithm_incremental &) = delete;
+
+    void set_heat_loss(const position &pos, unsigned value) {
+        check_position(map, pos);
+        pending_updates[pos] = value;
+    }
+
+    [[nodiscard]] unsigned get_minimal_heat_loss() {
+        if (!pending_updates.empty()) {
+            repair();
+        }
+
+        position end = {map.width()-1, map.height()-1};
+
+        unsigned minimal_heat_loss = maximal_heat_loss;
+        for (direction dir : {direction::SOUTH, direction::EAST}) {
+            for (unsigned count = 1; count <= step_history::max_count; ++count) {
+                minimal_heat_loss = std::min(minimal_heat_loss, heat_loss[graph.to_index(node{end, step_history{dir, count}})]);
+            }
+        }
+        return minimal_heat_loss;
+    }
+
+    // Throws away all distances and runs the search from scratch, applying pending updates first.
+    void solve() {
+        for (const auto &[pos, value] : pending_updates) {
+            map.set_heat_loss(pos, value);
+        }
+        pending_updates.clear();
+
+        heat_loss.assign(graph.size(), maximal_heat_loss);
+        affected.assign(heat_loss.size(), false);
+        heat_loss[graph.to_index(initial_node)] = 0;
+        queue = {};
+        queue.emplace(0, graph.to_index(initial_node));
+        repaired_nodes = propagate();
+    }
+
+private:
+    using queue_entry = std::pair<unsigned, index>;
+    std::priority_queue<queue_entry, std::vector<queue_entry>, std::greater<>> queue;
+    std::vector<bool> affected;
+
+    std::size_t propagate() {
+        std::size_t settled = 0;
+        while (!queue.empty()) {
+            const auto [current_heat_loss, current_index] = queue.top();
+            queue.pop();
+            if (current_heat_loss != heat_loss[current_index]) continue;
+            ++settled;
+
+            graph.for_each_successor(graph.to_node(current_index), [&](const node &next_node) {
+                const auto next_index = graph.to_index(next_node);
+                const auto tentative_heat_loss = current_heat_loss + map.heat_loss(next_node.pos);
+                if (tentative_heat_loss < heat_loss[next_index]) {
+                    heat_loss[next_index] = tentative_heat_loss;
+                    queue.emplace(tentative_heat_loss, next_index);
+                }
+            });
+        }
+        return settled;
+    }
+
+    // Best heat loss of a node reachable through any of its predecessors under the current weights.
+    [[nodiscard]] unsigned best_from_predecessors(const node &n) const {
+        unsigned best = maximal_heat_loss;
+        graph.for_each_predecessor(n, [&](const node &previous) {
+            const auto previous_heat_loss = heat_loss[graph.to_index(previous)];
+            if (previous_heat_loss != maximal_heat_loss) {
+                best = std::min(best, previous_heat_loss + map.heat_loss(n.pos));
+            }
+        });
+        return best;
+    }
+
+    // the start node keeps its heat loss of 0 whatever happens to the origin
+    template<typename F>
+    void for_each_node_at(const position &pos, F &&f) const {
+        graph.for_each_node_at(pos, [&f](const node &n) {
+            if (n != initial_node) {
+                f(n);
+            }
+        });
+    }
+
+    // Increases invalidate every node whose shortest path runs through a changed cell, i.e. the subtree of tight
+    // edges below the nodes at that cell. Those are reset and re-seeded from their untouched predecessors, while
+    // decreases only need their own cell re-seeded. A normal Dijkstra run from the seeds then repairs the rest.
+    void repair() {
+        std::vector<index> invalidated;
+
+        for (const auto &[pos, value] : pending_updates) {
+            if (value <= map.heat_loss(pos)) continue;
+            for_each_node_at(pos, [&](const node &n) {
+                const auto i = graph.to_index(n);
+                if (heat_loss[i] != maximal_heat_loss && !affected[i]) {
+                    affected[i] = true;
+                    invalidated.push_back(i);
+                }
+            });
+        }
+        for (std::size_t next = 0; next < invalidated.size(); ++next) {
+            const auto current_index = invalidated[next];
+            graph.for_each_successor(graph.to_node(current_index), [&](const node &next_node) {
+                const auto next_index = graph.to_index(next_node);
+                if (!affected[next_index] && next_node != initial_node
+                    && heat_loss[next_index] == heat_loss[current_index] + map.heat_loss(next_node.pos)) {
+                    affected[next_index] = true;
+                    invalidated.push_back(next_index);
+                }
+            });
+        }
+
+        for (const auto i : invalidated) {
+            heat_loss[i] = maximal_heat_loss;
+        }
+        for (const auto &[pos, value] : pending_updates) {
+            map.set_heat_loss(pos, value);
+        }
+
+        queue = {};
+        const auto seed = [&](const node &n) {
+            const auto i = graph.to_index(n);
+            const auto best = best_from_predecessors(n);
+            if (best < heat_loss[i]) {
+                heat_loss[i] = best;
+                queue.emplace(best, i);
+            }
+        };
+        for (const auto i : invalidated) {
+            affected[i] = false;
+            seed(graph.to_node(i));
+        }
+        for (const auto &[pos, value] : pending_updates) {
+            for_each_node_at(pos, seed);
+        }
+        pending_updates.clear();
+
+        repaired_nodes = propagate();
+    }
+};
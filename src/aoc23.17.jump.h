@@ -0,0 +1,119 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <array>
+#include <format>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+// Dijkstra that jumps over straight runs: every queued state has just turned, and its expansion walks straight up
+// to the maximal run length, pushing the two turns off every cell of the way. The states in the middle of a run are
+// never queued, so a cell has four states instead of twelve and each expansion does the work of up to three. The
+// heat loss of a run is summed while walking, and a target on the way is only recorded, the answer being final once
+// the queue has nothing cheaper left. Works on any heat_loss_map, which may also be a reference to one.
+template<heat_loss_map Map>
+struct basic_heat_loss_algorithm_jump {
+    using position = city_map::position;
+    using index = std::size_t;
+    static constexpr unsigned max_count = heat_loss_algorithm_dijkstra::step_history::max_count;
+    static constexpr auto maximal_heat_loss = heat_loss_algorithm::maximal_heat_loss;
+
+    Map map;
+    heat_loss_query query;
+    lazy_heat_loss_table heat_loss;
+    std::size_t expanded_nodes = 0;
+    std::size_t pushed_nodes = 0;
+    mutable solver_stats stats;
+
+    basic_heat_loss_algorithm_jump(const Map &map, const heat_loss_query &query)
+            : map(map), query(query), heat_loss(map.width() * map.height() * 4) {
+        check_position(map, query.source);
+        check_position(map, query.target);
+        check_max_count(query);
+    }
+
+    unsigned run() {
+        return stats.time(&solver_stats::search_time, [this] {
+            // heat loss, state
+            using entry = std::tuple<unsigned, index>;
+            std::priority_queue<entry, std::vector<entry>, std::greater<>> queue;
+            const auto push = [&](const position &pos, direction dir, unsigned tentative_heat_loss) {
+                stats.count(&solver_stats::relaxations);
+                const auto i = to_index(pos, dir);
+                if (tentative_heat_loss < heat_loss.get(i)) {
+                    stats.count(&solver_stats::decreases);
+                    stats.count(&solver_stats::nodes_pushed);
+                    ++pushed_nodes;
+                    heat_loss.set(i, tentative_heat_loss);
+                    queue.emplace(tentative_heat_loss, i);
+                }
+            };
+            push(query.source, heat_loss_algorithm_dijkstra::initial_node.history.dir, 0);
+
+            // the target reached in the middle of a run
+            unsigned best = maximal_heat_loss;
+            while (!queue.empty()) {
+                const auto [current_heat_loss, current_index] = queue.top();
+                queue.pop();
+                if (current_heat_loss != heat_loss.get(current_index)) {
+                    stats.count(&solver_stats::stale_pops);
+                    continue;
+                }
+                if (current_heat_loss >= best) return best;
+                stats.count(&solver_stats::nodes_popped);
+                ++expanded_nodes;
+
+                const position current{current_index / 4 % map.width(), current_index / 4 / map.width()};
+                const auto dir = static_cast<direction>(current_index % 4);
+                if (current == query.target) return current_heat_loss;
+
+                // the popped state has run one cell, so it may go straight on for max_count - 1 more
+                auto pos = current;
+                auto run_heat_loss = current_heat_loss;
+                for (unsigned count = 1;; ++count) {
+                    for (const auto turned : turns(dir)) {
+                        if (const auto next = step(map, pos, turned)) {
+                            push(*next, turned, run_heat_loss + map.heat_loss(*next));
+                        }
+                    }
+                    if (count == max_count) break;
+                    const auto next = step(map, pos, dir);
+                    if (!next) break;
+                    pos = *next;
+                    run_heat_loss += map.heat_loss(pos);
+                    if (pos == query.target) best = std::min(best, run_heat_loss);
+                }
+                stats.track_max(&solver_stats::max_queue_size, queue.size());
+            }
+            return best;
+        });
+    }
+
+private:
+    [[nodiscard]] index to_index(const position &pos, direction dir) const {
+        return (pos.y * map.width() + pos.x) * 4 + static_cast<std::size_t>(dir);
+    }
+};
+
+using heat_loss_algorithm_jump = basic_heat_loss_algorithm_jump<city_map_view>;
+
+inline unsigned minimal_heat_loss_jump(city_map_view map, const heat_loss_query &query) {
+    heat_loss_algorithm_jump algorithm{map, query};
+    return algorithm.run();
+}
+
+// The exact answer on maps other than city_map, like the ones computed on the fly: the jump engine is the fastest
+// exact engine without preprocessing. It only refers to the map, so that packed_city_map is not copied either.
+template<heat_loss_map Map> requires (!std::convertible_to<Map, city_map_view>)
+unsigned minimal_heat_loss(const Map &map, const heat_loss_query &query) {
+    basic_heat_loss_algorithm_jump<const Map &> algorithm{map, query};
+    return algorithm.run();
+}
+
+template<heat_loss_map Map> requires (!std::convertible_to<Map, city_map_view>)
+unsigned minimal_heat_loss(const Map &map) {
+    return minimal_heat_loss(map, heat_loss_query::whole_map(map));
+}
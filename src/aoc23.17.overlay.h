@@ -0,0 +1,484 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <ranges>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Overlay graph for repeated queries on a map that is patched now and then. The map is cut into square tiles; the
+// overlay nodes are the entry states of the tiles, i.e. the states whose step came from another tile. A search
+// confined to the tile gives the exact heat loss from each entry state to each entry state of a neighbouring tile
+// that can be reached by leaving the tile, which makes one clique per tile. The entry states of one side of a tile
+// are searched together, one lane each. A query only searches the tiles of source and target state by state and the
+// overlay in between. As the cost of an overlay edge only depends on the cells of the tile it crosses, a changed
+// cell only invalidates the clique of its own tile.
+// Like heat_loss_algorithm_incremental it owns its copy of the map. Changes are collected with set_heat_loss()
+// and the affected cliques are recomputed on the next query.
+class tile_overlay {
+public:
+    using position = city_map::position;
+    using node = heat_loss_state_graph::node;
+    using index = std::uint32_t;
+
+    static constexpr std::size_t default_tile_size = 16;
+
+    // The cliques are computed on up to `threads` threads
+    explicit tile_overlay(city_map map, std::size_t tile_size = default_tile_size,
+                          unsigned threads = std::thread::hardware_concurrency())
+            : map(std::move(map)), tile_size(tile_size) {
+        if (tile_size == 0) {
+            throw std::invalid_argument("tile size must be positive");
+        }
+        tiles_x = (this->map.width() + tile_size - 1) / tile_size;
+        tiles_y = (this->map.height() + tile_size - 1) / tile_size;
+        collect_entries();
+        cliques.resize(tile_count());
+        scratch = tile_search_space(tile_size);
+
+        const auto workers = std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(tile_count(), 1));
+        {
+            std::vector<std::jthread> pool;
+            for (std::size_t worker = 0; worker < workers; ++worker) {
+                pool.emplace_back([this, worker, workers] {
+                    clique_space space;
+                    for (auto tile = worker; tile < tile_count(); tile += workers) {
+                        compute_clique(tile, space);
+                    }
+                });
+            }
+        }
+        recomputed_tiles = tile_count();
+        overlay_heat_loss.assign(entry_states.size() + 1, heat_loss_algorithm::maximal_heat_loss);
+        cost_to_target.assign(entry_states.size(), heat_loss_algorithm::maximal_heat_loss);
+    }
+
+    void set_heat_loss(const position &pos, unsigned value) {
+        check_position(map, pos);
+        if (map.heat_loss(pos) == value) return;
+        map.set_heat_loss(pos, value);
+        dirty_tiles.insert(tile_of(pos));
+    }
+
+    [[nodiscard]] unsigned minimal_heat_loss(const heat_loss_query &query) {
+        check_position(map, query.source);
+        check_position(map, query.target);
+        check_max_count(query);
+        update_cliques();
+        return search(query);
+    }
+
+    [[nodiscard]] const city_map &get_map() const { return map; }
+    [[nodiscard]] std::size_t tile_count() const { return tiles_x * tiles_y; }
+    [[nodiscard]] std::size_t entry_count() const { return entry_states.size(); }
+
+    [[nodiscard]] std::size_t edge_count() const {
+        std::size_t count = 0;
+        for (const auto &clique : cliques) count += clique.edges.size();
+        return count;
+    }
+
+    // Cliques computed since construction, for the tests and the benchmark
+    std::size_t recomputed_tiles = 0;
+    // Overlay nodes settled by the last query
+    std::size_t settled_entries = 0;
+
+private:
+    using row_major_graph = basic_heat_loss_state_graph<row_major_state_layout>;
+    static constexpr index no_entry = std::numeric_limits<index>::max();
+    // far enough below the maximum that adding the heat loss of a run cannot overflow
+    static constexpr unsigned unreached = std::numeric_limits<unsigned>::max() / 2;
+
+    struct edge {
+        index to;
+        unsigned heat_loss;
+    };
+
+    // Edges of the entry states of one tile, numbered from the first entry state of the tile
+    struct clique {
+        std::vector<std::uint32_t> offsets;
+        std::vector<edge> edges;
+    };
+
+    city_map map;
+    std::size_t tile_size;
+    std::size_t tiles_x = 0;
+    std::size_t tiles_y = 0;
+    std::vector<index> entry_of_state;
+    std::vector<row_major_graph::index> entry_states;
+    std::vector<index> tile_entries; // first entry state per tile, and one past the last
+    std::vector<clique> cliques;
+    std::set<std::size_t> dirty_tiles;
+
+    // State by state search within one tile; the table is reset after use
+    struct tile_search_space {
+        explicit tile_search_space(std::size_t tile_size = 0)
+                : heat_loss(tile_size * tile_size * heat_loss_state_graph::states_per_cell,
+                            heat_loss_algorithm::maximal_heat_loss) {}
+
+        std::vector<unsigned> heat_loss;
+        std::vector<std::size_t> reached;
+
+        void reset() {
+            for (const auto i : reached) heat_loss[i] = heat_loss_algorithm::maximal_heat_loss;
+            reached.clear();
+        }
+    };
+
+    // The table of a state_graph_search within one tile: the states of the map mapped to the scratch space
+    class tile_table {
+    public:
+        tile_table(const tile_overlay &overlay, std::size_t tile, tile_search_space &space)
+                : overlay(overlay), tile(tile), space(space) {}
+
+        [[nodiscard]] unsigned get(std::size_t i) const {
+            return space.heat_loss[local(i)];
+        }
+
+        void set(std::size_t i, unsigned heat_loss) {
+            auto &value = space.heat_loss[local(i)];
+            if (value == heat_loss_algorithm::maximal_heat_loss) space.reached.push_back(local(i));
+            value = heat_loss;
+        }
+
+    private:
+        const tile_overlay &overlay;
+        std::size_t tile;
+        tile_search_space &space;
+
+        [[nodiscard]] std::size_t local(std::size_t i) const {
+            return overlay.local_index(tile, overlay.graph().to_node(i));
+        }
+    };
+
+    // Scratch space for the cliques of one tile, over the states that have just turned, as in
+    // heat_loss_algorithm_jump
+    struct clique_space {
+        // from a state to a state, or to an exit slot
+        struct jump {
+            std::uint32_t from;
+            std::uint32_t to;
+            unsigned heat_loss;
+        };
+
+        std::vector<jump> jumps;
+        std::vector<jump> exit_jumps;
+        // the entry states of neighbouring tiles that can be stepped into, sorted, one slot each
+        std::vector<index> exits;
+        // the entry states searched together
+        std::vector<index> lanes;
+        // per state and lane
+        std::vector<unsigned> heat_loss;
+        // per entry state of the tile and exit slot
+        std::vector<unsigned> exit_heat_loss;
+    };
+
+    tile_search_space scratch;
+    clique_space clique_scratch;
+    std::vector<unsigned> overlay_heat_loss;
+    std::vector<unsigned> cost_to_target;
+    std::vector<index> touched;
+
+    [[nodiscard]] row_major_graph graph() const { return row_major_graph{map}; }
+
+    [[nodiscard]] std::size_t tile_of(const position &pos) const {
+        return pos.y / tile_size * tiles_x + pos.x / tile_size;
+    }
+
+    [[nodiscard]] position tile_origin(std::size_t tile) const {
+        return {tile % tiles_x * tile_size, tile / tiles_x * tile_size};
+    }
+
+    // State index within the tile for the scratch table
+    [[nodiscard]] std::size_t local_index(std::size_t tile, const node &n) const {
+        const auto origin = tile_origin(tile);
+        return (((n.pos.y - origin.y) * tile_size + n.pos.x - origin.x) * heat_loss_state_graph::all_directions.size()
+                + static_cast<std::size_t>(n.history.dir)) * heat_loss_state_graph::step_history::max_count
+               + n.history.count - 1;
+    }
+
+    void collect_entries() {
+        const auto g = graph();
+        entry_of_state.assign(g.size(), no_entry);
+        for (std::size_t tile = 0; tile < tile_count(); ++tile) {
+            tile_entries.push_back(static_cast<index>(entry_states.size()));
+            const auto origin = tile_origin(tile);
+            for (auto y = origin.y; y < std::min(origin.y + tile_size, map.height()); ++y) {
+                for (auto x = origin.x; x < std::min(origin.x + tile_size, map.width()); ++x) {
+                    g.for_each_node_at({x, y}, [&](const node &n) {
+                        const auto previous = step(map, n.pos, opposite(n.history.dir));
+                        if (previous && tile_of(*previous) != tile) {
+                            entry_of_state[g.to_index(n)] = static_cast<index>(entry_states.size());
+                            entry_states.push_back(g.to_index(n));
+                        }
+                    });
+                }
+            }
+        }
+        tile_entries.push_back(static_cast<index>(entry_states.size()));
+    }
+
+    // Dijkstra from one state that stays within its tile. Calls on_exit(entry, heat_loss) for each entry state of a
+    // neighbouring tile it steps into, with the heat loss before entering it, and on_settle(state, heat_loss) for
+    // each state of the tile in order.
+    template<typename Exit, typename Settle>
+    void tile_search(std::size_t tile, const node &start, unsigned start_heat_loss, tile_search_space &space,
+                     Exit &&on_exit, Settle &&on_settle) const {
+        const auto g = graph();
+        tile_table heat_loss{*this, tile, space};
+        auto search = make_state_graph_search(g, heat_loss, search_direction::forward,
+                                              [](const node &) { return 0u; },
+                                              [&](const node &n) { return tile_of(n.pos) == tile; });
+        search.reach(start, start_heat_loss);
+        search.run(on_settle, [&](const node &next, unsigned current_heat_loss) {
+            on_exit(entry_of_state[g.to_index(next)], current_heat_loss);
+        });
+        space.reset();
+    }
+
+    // Local number of the state at pos of the tile that has just turned into dir
+    [[nodiscard]] std::uint32_t jump_state(std::size_t tile, const position &pos, direction dir) const {
+        const auto origin = tile_origin(tile);
+        return static_cast<std::uint32_t>(((pos.y - origin.y) * tile_size + pos.x - origin.x)
+                                          * heat_loss_state_graph::all_directions.size()
+                                          + static_cast<std::size_t>(dir));
+    }
+
+    // The jumps of heat_loss_algorithm_jump from pos, entered in direction dir with run length count: the turns off
+    // every cell of the straight run that goes on from there. Calls on_state(state, heat_loss) for a turn within the
+    // tile, with the heat loss after pos up to and including the cell turned into, and on_exit(entry, heat_loss) for
+    // a step into an entry state of a neighbouring tile, with the heat loss after pos before entering it.
+    template<typename State, typename Exit>
+    void for_each_jump(std::size_t tile, position pos, direction dir, unsigned count, State &&on_state,
+                       Exit &&on_exit) const {
+        const auto g = graph();
+        unsigned run_heat_loss = 0;
+        for (;; ++count) {
+            for (const auto turned : turns(dir)) {
+                const auto next = step(map, pos, turned);
+                if (!next) continue;
+                if (tile_of(*next) == tile) {
+                    on_state(jump_state(tile, *next, turned), run_heat_loss + map.heat_loss(*next));
+                } else {
+                    on_exit(entry_of_state[g.to_index({*next, {turned, 1}})], run_heat_loss);
+                }
+            }
+            if (count == heat_loss_state_graph::step_history::max_count) break;
+            const auto next = step(map, pos, dir);
+            if (!next) break;
+            if (tile_of(*next) != tile) {
+                on_exit(entry_of_state[g.to_index({*next, {dir, count + 1}})], run_heat_loss);
+                break;
+            }
+            pos = *next;
+            run_heat_loss += map.heat_loss(pos);
+        }
+    }
+
+    void compute_clique(std::size_t tile, clique_space &space) {
+        const auto g = graph();
+        const auto origin = tile_origin(tile);
+        space.jumps.clear();
+        space.exit_jumps.clear();
+        space.exits.clear();
+        for (auto y = origin.y; y < std::min(origin.y + tile_size, map.height()); ++y) {
+            for (auto x = origin.x; x < std::min(origin.x + tile_size, map.width()); ++x) {
+                for (const auto dir : heat_loss_state_graph::all_directions) {
+                    const auto from = jump_state(tile, {x, y}, dir);
+                    for_each_jump(tile, {x, y}, dir, 1,
+                                  [&](std::uint32_t to, unsigned heat_loss) {
+                                      space.jumps.push_back({from, to, heat_loss});
+                                  },
+                                  [&](index exit, unsigned heat_loss) {
+                                      space.exit_jumps.push_back({from, exit, heat_loss});
+                                      space.exits.push_back(exit);
+                                  });
+                }
+            }
+        }
+        // in a tile narrower than a run an entry state can leave it straight on with a longer run than any of the
+        // turned states
+        for (auto e = tile_entries[tile]; e < tile_entries[tile + 1]; ++e) {
+            const auto n = g.to_node(entry_states[e]);
+            for_each_jump(tile, n.pos, n.history.dir, n.history.count, [](std::uint32_t, unsigned) {},
+                          [&](index exit, unsigned) { space.exits.push_back(exit); });
+        }
+        std::ranges::sort(space.exits);
+        const auto [duplicates, exits_end] = std::ranges::unique(space.exits);
+        space.exits.erase(duplicates, exits_end);
+        for (auto &j : space.exit_jumps) j.to = exit_slot(space, j.to);
+
+        const auto first = tile_entries[tile];
+        const auto entries = tile_entries[tile + 1] - first;
+        space.exit_heat_loss.assign(entries * space.exits.size(), unreached);
+        // the entry states of one side all step in the same direction
+        for (const auto dir : heat_loss_state_graph::all_directions) {
+            space.lanes.clear();
+            for (auto e = first; e < tile_entries[tile + 1]; ++e) {
+                const auto n = g.to_node(entry_states[e]);
+                if (n.history.dir != dir) continue;
+                // without a single jump it cannot reach an exit, e.g. at the end of a map one cell wide
+                bool moves = false;
+                const auto moved = [&moves](auto, unsigned) { moves = true; };
+                for_each_jump(tile, n.pos, dir, n.history.count, moved, moved);
+                if (moves) space.lanes.push_back(e);
+            }
+            if (!space.lanes.empty()) sweep_side(tile, space);
+        }
+
+        auto &result = cliques[tile];
+        result.offsets.assign(1, 0);
+        result.edges.clear();
+        for (std::size_t e = 0; e < entries; ++e) {
+            for (std::size_t slot = 0; slot < space.exits.size(); ++slot) {
+                const auto heat_loss = space.exit_heat_loss[e * space.exits.size() + slot];
+                if (heat_loss != unreached) result.edges.push_back({space.exits[slot], heat_loss});
+            }
+            result.offsets.push_back(static_cast<std::uint32_t>(result.edges.size()));
+        }
+    }
+
+    [[nodiscard]] static std::uint32_t exit_slot(const clique_space &space, index exit) {
+        return static_cast<std::uint32_t>(std::ranges::lower_bound(space.exits, exit) - space.exits.begin());
+    }
+
+    // One search from all entry states in space.lanes at once, each with a lane of its own in the heat loss of every
+    // state. Like heat_loss_algorithm_sweep it relaxes all jumps in alternating passes until a pass changes nothing,
+    // and the lanes of a jump are relaxed together.
+    void sweep_side(std::size_t tile, clique_space &space) const {
+        const auto g = graph();
+        const auto lanes = space.lanes.size();
+        const auto slots = space.exits.size();
+        auto &heat_loss = space.heat_loss;
+        heat_loss.assign(tile_size * tile_size * heat_loss_state_graph::all_directions.size() * lanes,
+                         unreached);
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+            const auto n = g.to_node(entry_states[space.lanes[lane]]);
+            const auto entry_heat_loss = map.heat_loss(n.pos);
+            auto *exit_heat_loss = &space.exit_heat_loss[(space.lanes[lane] - tile_entries[tile]) * slots];
+            for_each_jump(tile, n.pos, n.history.dir, n.history.count,
+                          [&](std::uint32_t to, unsigned value) {
+                              auto &current = heat_loss[to * lanes + lane];
+                              current = std::min(current, entry_heat_loss + value);
+                          },
+                          [&](index exit, unsigned value) {
+                              auto &current = exit_heat_loss[exit_slot(space, exit)];
+                              current = std::min(current, entry_heat_loss + value);
+                          });
+        }
+
+        const auto relax = [&](const clique_space::jump &j) {
+            const auto *from = &heat_loss[j.from * lanes];
+            auto *to = &heat_loss[j.to * lanes];
+            unsigned changed = 0;
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                const auto value = std::min(to[lane], from[lane] + j.heat_loss);
+                changed |= value ^ to[lane];
+                to[lane] = value;
+            }
+            return changed != 0;
+        };
+        for (bool top_down = true;; top_down = !top_down) {
+            bool changed = false;
+            if (top_down) {
+                for (const auto &j : space.jumps) changed |= relax(j);
+            } else {
+                for (const auto &j : std::views::reverse(space.jumps)) changed |= relax(j);
+            }
+            if (!changed) break;
+        }
+
+        for (const auto &j : space.exit_jumps) {
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                auto &current = space.exit_heat_loss[(space.lanes[lane] - tile_entries[tile]) * slots + j.to];
+                current = std::min(current, heat_loss[j.from * lanes + lane] + j.heat_loss);
+            }
+        }
+    }
+
+    void update_cliques() {
+        for (const auto tile : dirty_tiles) {
+            compute_clique(tile, clique_scratch);
+            ++recomputed_tiles;
+        }
+        dirty_tiles.clear();
+    }
+
+    // Heat loss from each entry state of the target tile to the target within the tile, including the cell of the
+    // entry state, by a backwards search from the states at the target
+    void compute_cost_to_target(const position &target) {
+        const auto g = graph();
+        const auto tile = tile_of(target);
+        for (auto e = tile_entries[tile]; e < tile_entries[tile + 1]; ++e) {
+            cost_to_target[e] = heat_loss_algorithm::maximal_heat_loss;
+        }
+        tile_table cost{*this, tile, scratch};
+        auto search = make_state_graph_search(g, cost, search_direction::backward,
+                                              [](const node &) { return 0u; },
+                                              [&](const node &n) { return tile_of(n.pos) == tile; });
+        // the backward search counts the cells after a state, the cost to the target includes its own cell
+        g.for_each_node_at(target, [&](const node &n) { search.reach(n, 0); });
+        search.run([&](const node &n, unsigned current_cost) {
+            if (const auto e = entry_of_state[g.to_index(n)]; e != no_entry) {
+                cost_to_target[e] = current_cost + map.heat_loss(n.pos);
+            }
+        });
+        scratch.reset();
+    }
+
+    unsigned search(const heat_loss_query &query) {
+        const auto target_tile = tile_of(query.target);
+        const auto target_node = static_cast<index>(entry_states.size());
+        compute_cost_to_target(query.target);
+        for (const auto i : touched) overlay_heat_loss[i] = heat_loss_algorithm::maximal_heat_loss;
+        touched.clear();
+        settled_entries = 0;
+
+        // overlay heat loss: before entering the cell of the entry state
+        using entry = std::pair<unsigned, index>;
+        std::priority_queue<entry, std::vector<entry>, std::greater<>> queue;
+        const auto reach = [&](index i, unsigned heat_loss) {
+            if (heat_loss < overlay_heat_loss[i]) {
+                if (overlay_heat_loss[i] == heat_loss_algorithm::maximal_heat_loss) touched.push_back(i);
+                overlay_heat_loss[i] = heat_loss;
+                queue.emplace(heat_loss, i);
+            }
+        };
+
+        // the source tile state by state, up to where the path leaves it for the first time
+        const auto source_tile = tile_of(query.source);
+        tile_search(source_tile, heat_loss_state_graph::start_node(query.source), 0, scratch, reach,
+                    [&](const node &n, unsigned heat_loss) {
+                        if (n.pos == query.target) reach(target_node, heat_loss);
+                    });
+
+        const auto g = graph();
+        while (!queue.empty()) {
+            const auto [current_heat_loss, current] = queue.top();
+            queue.pop();
+            if (current_heat_loss != overlay_heat_loss[current]) continue;
+            if (current == target_node) return current_heat_loss;
+            ++settled_entries;
+
+            const auto tile = tile_of(g.to_node(entry_states[current]).pos);
+            if (tile == target_tile && cost_to_target[current] != heat_loss_algorithm::maximal_heat_loss) {
+                reach(target_node, current_heat_loss + cost_to_target[current]);
+            }
+            const auto &edges = cliques[tile];
+            const auto local = current - tile_entries[tile];
+            for (auto k = edges.offsets[local]; k < edges.offsets[local + 1]; ++k) {
+                reach(edges.edges[k].to, current_heat_loss + edges.edges[k].heat_loss);
+            }
+        }
+        return heat_loss_algorithm::maximal_heat_loss;
+    }
+};
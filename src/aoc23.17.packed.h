@@ -0,0 +1,106 @@
+#pragma once
+
+#include "aoc23.17.h"
+#include "aoc23.17.relax.h"
+
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+// City map with two cells per byte, the even column in the low nibble. Heat losses are digits, so four bits hold
+// any of them and a map takes an eighth of the memory of a city_map. Rows start on a byte boundary. Solvers read
+// maps through city_map_view, so they work on rows unpacked into a buffer by unpack_row(), which does 32 cells per
+// iteration with AVX2.
+class packed_city_map {
+public:
+    using position = city_map::position;
+    static constexpr unsigned max_heat_loss = 15;
+
+    explicit packed_city_map(city_map_view map)
+            : columns(map.width()), rows(map.height()), row_bytes((map.width() + 1) / 2), bytes(row_bytes * rows) {
+        for (std::size_t y = 0; y < rows; ++y) {
+            const auto *cells = map.row_data(y);
+            for (std::size_t x = 0; x < columns; ++x) {
+                set_heat_loss({x, y}, cells[x]);
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t width() const { return columns; }
+    [[nodiscard]] std::size_t height() const { return rows; }
+
+    [[nodiscard]] unsigned heat_loss(const position &p) const {
+        return bytes[p.y * row_bytes + p.x / 2] >> (p.x % 2 * 4) & 0xfu;
+    }
+
+    void set_heat_loss(const position &p, unsigned value) {
+        check_position(*this, p);
+        if (value > max_heat_loss) {
+            throw std::invalid_argument(std::format("heat loss {} at ({}, {}) does not fit into four bits",
+                                                    value, p.x, p.y));
+        }
+        auto &byte = bytes[p.y * row_bytes + p.x / 2];
+        const auto shift = p.x % 2 * 4;
+        byte = static_cast<std::uint8_t>((byte & ~(0xfu << shift)) | value << shift);
+    }
+
+    // Writes the width() cells of row y to out
+    void unpack_row(std::size_t y, unsigned *out, relax_kernel kernel = best_relax_kernel()) const {
+        const auto *packed = bytes.data() + y * row_bytes;
+        std::size_t x = 0;
+#if AOC_HAVE_AVX2_KERNEL
+        if (kernel == relax_kernel::avx2) {
+            x = unpack_avx2(packed, columns, out);
+        }
+#else
+        (void) kernel;
+#endif
+        for (; x < columns; ++x) {
+            out[x] = packed[x / 2] >> (x % 2 * 4) & 0xfu;
+        }
+    }
+
+    // All rows unpacked, for the solvers that need the whole map
+    [[nodiscard]] city_map unpack() const {
+        city_map map;
+        city_map::row r(columns);
+        for (std::size_t y = 0; y < rows; ++y) {
+            unpack_row(y, r.data());
+            map.add_row(r);
+        }
+        return map;
+    }
+
+    [[nodiscard]] std::size_t memory_bytes() const { return bytes.size(); }
+
+private:
+    std::size_t columns;
+    std::size_t rows;
+    std::size_t row_bytes;
+    std::vector<std::uint8_t> bytes;
+
+#if AOC_HAVE_AVX2_KERNEL
+    // 16 bytes into 32 cells: split the nibbles, interleave them back into column order and widen each byte to 32
+    // bits. Returns the number of cells done, the rest is left to the scalar loop.
+    __attribute__((target("avx2")))
+    static std::size_t unpack_avx2(const std::uint8_t *packed, std::size_t width, unsigned *out) {
+        constexpr std::size_t cells_per_step = 32;
+        const auto vector_end = width / cells_per_step * cells_per_step;
+        const auto nibble = _mm_set1_epi8(0x0f);
+        for (std::size_t x = 0; x < vector_end; x += cells_per_step) {
+            const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(packed + x / 2));
+            const auto even = _mm_and_si128(b, nibble);
+            const auto odd = _mm_and_si128(_mm_srli_epi16(b, 4), nibble);
+            const auto first = _mm_unpacklo_epi8(even, odd);
+            const auto second = _mm_unpackhi_epi8(even, odd);
+            auto *o = reinterpret_cast<__m256i *>(out + x);
+            _mm256_storeu_si256(o, _mm256_cvtepu8_epi32(first));
+            _mm256_storeu_si256(o + 1, _mm256_cvtepu8_epi32(_mm_srli_si128(first, 8)));
+            _mm256_storeu_si256(o + 2, _mm256_cvtepu8_epi32(second));
+            _mm256_storeu_si256(o + 3, _mm256_cvtepu8_epi32(_mm_srli_si128(second, 8)));
+        }
+        return vector_end;
+    }
+#endif
+};
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// Downsampled copies of a map: on level k every cell stands for a block of 2^k x 2^k cells and holds the cheapest
+// of them, level 0 being the map itself. Every cell a path enters in a block costs at least that much, and a path
+// that crosses a block straight through enters a whole row or column of it, so a search over the blocks of a coarse
+// level yields lower bounds for the real heat loss. They see expensive regions and detours around them, which the
+// cheapest cell times the Manhattan distance does not.
+class cost_pyramid {
+public:
+    using position = city_map::position;
+
+    // Halves the map until a single cell is left
+    explicit cost_pyramid(city_map_view map)
+            : map(map) {
+        const auto start_time = std::chrono::steady_clock::now();
+        auto width = map.width();
+        auto height = map.height();
+        while (width > 1 || height > 1) {
+            const auto coarse_width = (width + 1) / 2;
+            const auto coarse_height = (height + 1) / 2;
+            std::vector<unsigned> coarse(coarse_width * coarse_height, heat_loss_algorithm::maximal_heat_loss);
+            const auto k = level_count() - 1;
+            for (std::size_t y = 0; y < height; ++y) {
+                for (std::size_t x = 0; x < width; ++x) {
+                    auto &value = coarse[y / 2 * coarse_width + x / 2];
+                    value = std::min(value, cheapest(k, {x, y}));
+                }
+            }
+            levels.push_back({coarse_width, coarse_height, std::move(coarse)});
+            width = coarse_width;
+            height = coarse_height;
+        }
+        build_time = std::chrono::steady_clock::now() - start_time;
+    }
+
+    // the pyramid only keeps a view, so it must not be built for a temporary map
+    explicit cost_pyramid(city_map &&) = delete;
+
+    [[nodiscard]] std::size_t level_count() const { return levels.size() + 1; }
+
+    [[nodiscard]] std::size_t level_width(std::size_t level) const {
+        return level == 0 ? map.width() : levels[level - 1].width;
+    }
+
+    [[nodiscard]] std::size_t level_height(std::size_t level) const {
+        return level == 0 ? map.height() : levels[level - 1].height;
+    }
+
+    // The cheapest cell of the block at pos on the given level
+    [[nodiscard]] unsigned cheapest(std::size_t level, const position &pos) const {
+        if (level == 0) return map.heat_loss(pos);
+        const auto &l = levels[level - 1];
+        return l.cells[pos.y * l.width + pos.x];
+    }
+
+    // Lower bound for the heat loss from any state at a position to one target. A path from pos either stays in the
+    // block of the target, or leaves the block of pos in some direction, entering each cell up to the border, and
+    // continues with the bound for entering the next block in that direction. Consistent, and so is the maximum with
+    // the cheapest cell times the Manhattan distance.
+    class heuristic {
+    public:
+        [[nodiscard]] unsigned operator()(const position &pos) const {
+            const auto dx = pos.x > target.x ? pos.x - target.x : target.x - pos.x;
+            const auto dy = pos.y > target.y ? pos.y - target.y : target.y - pos.y;
+            const auto manhattan = static_cast<unsigned>(dx + dy);
+
+            const position block_pos{pos.x >> level, pos.y >> level};
+            const auto block = block_pos.y * width + block_pos.x;
+            const auto exit = [&](direction dir, std::size_t cells) {
+                return exit_costs[block * 4 + static_cast<std::size_t>(dir)]
+                       + static_cast<unsigned>(cells) * cheapest[block];
+            };
+            const auto first = [this](std::size_t b) { return b << level; };
+            const auto last = [this](std::size_t b, std::size_t size) { return std::min((b + 1) << level, size) - 1; };
+            auto bound = std::min({exit(direction::NORTH, pos.y - first(block_pos.y)),
+                                   exit(direction::SOUTH, last(block_pos.y, map_height) - pos.y),
+                                   exit(direction::WEST, pos.x - first(block_pos.x)),
+                                   exit(direction::EAST, last(block_pos.x, map_width) - pos.x)});
+            if (block == target_block) {
+                bound = std::min(bound, manhattan * cheapest[block]);
+            }
+            return std::max(bound, manhattan * minimal_cell_heat_loss);
+        }
+
+        // Time spent on the search over the blocks
+        std::chrono::nanoseconds build_time{};
+
+    private:
+        friend class cost_pyramid;
+
+        position target;
+        std::size_t level = 0;
+        std::size_t width = 0;
+        std::size_t map_width = 0;
+        std::size_t map_height = 0;
+        std::size_t target_block = 0;
+        unsigned minimal_cell_heat_loss = 0;
+        std::vector<unsigned> cheapest;
+        // per block and direction: the bound from entering the next block in that direction on
+        std::vector<unsigned> exit_costs;
+    };
+
+    // Searches backwards from the block of the target on the given level, clamped to the levels there are. Each level
+    // has a quarter of the cells of the one below, so the search gets cheaper, and the bound looser: the cheapest cell
+    // of a block stands for all of them, which on noisy maps is little more than the cheapest cell overall. Level 0
+    // is the tightest, coarser levels pay off on maps whose expensive regions span whole blocks.
+    [[nodiscard]] heuristic heuristic_to(const position &target, std::size_t level = 0) const {
+        check_position(map, target);
+        const auto start_time = std::chrono::steady_clock::now();
+        level = std::min(level, level_count() - 1);
+        const auto width = level_width(level);
+        const auto height = level_height(level);
+        heuristic h;
+        h.target = target;
+        h.level = level;
+        h.width = width;
+        h.map_width = map.width();
+        h.map_height = map.height();
+        h.target_block = (target.y >> level) * width + (target.x >> level);
+        h.minimal_cell_heat_loss = cheapest(level_count() - 1, {0, 0});
+        for (std::size_t y = 0; y < height; ++y) {
+            for (std::size_t x = 0; x < width; ++x) {
+                h.cheapest.push_back(cheapest(level, {x, y}));
+            }
+        }
+
+        // cells of a block along one axis, the last blocks may be cut off by the map border
+        const auto extent = [level](std::size_t b, std::size_t size) {
+            return static_cast<unsigned>(std::min((b + 1) << level, size) - (b << level));
+        };
+        const auto neighbor = [&](std::size_t block, direction dir) -> std::optional<std::size_t> {
+            const auto x = block % width;
+            const auto y = block / width;
+            switch (dir) {
+                case direction::NORTH:
+                    return y == 0 ? std::nullopt : std::optional(block - width);
+                case direction::SOUTH:
+                    return y + 1 == height ? std::nullopt : std::optional(block + width);
+                case direction::WEST:
+                    return x == 0 ? std::nullopt : std::optional(block - 1);
+                case direction::EAST:
+                    return x + 1 == width ? std::nullopt : std::optional(block + 1);
+            }
+            return std::nullopt;
+        };
+
+        // bound from entering a block moving in a direction, including the cell entered
+        std::vector<unsigned> entering(width * height * 4, unreachable);
+        using entry = std::pair<unsigned, std::size_t>;
+        std::priority_queue<entry, std::vector<entry>, std::greater<>> queue;
+        const auto relax = [&](std::size_t block, direction dir, unsigned cost) {
+            const auto i = block * 4 + static_cast<std::size_t>(dir);
+            if (cost < entering[i]) {
+                entering[i] = cost;
+                queue.emplace(cost, i);
+            }
+        };
+        // in the block of the target, from the border entered to the row or column of the target
+        const auto first_x = (target.x >> level) << level;
+        const auto first_y = (target.y >> level) << level;
+        const auto target_cheapest = h.cheapest[h.target_block];
+        relax(h.target_block, direction::EAST, static_cast<unsigned>(1 + target.x - first_x) * target_cheapest);
+        relax(h.target_block, direction::WEST,
+              (extent(target.x >> level, map.width()) - static_cast<unsigned>(target.x - first_x)) * target_cheapest);
+        relax(h.target_block, direction::SOUTH, static_cast<unsigned>(1 + target.y - first_y) * target_cheapest);
+        relax(h.target_block, direction::NORTH,
+              (extent(target.y >> level, map.height()) - static_cast<unsigned>(target.y - first_y)) * target_cheapest);
+
+        while (!queue.empty()) {
+            const auto [cost, current] = queue.top();
+            queue.pop();
+            if (cost != entering[current]) continue;
+
+            // the block the path came from, crossing it straight or entering it from any other side
+            const auto dir = static_cast<direction>(current % 4);
+            const auto previous = neighbor(current / 4, opposite(dir));
+            if (!previous) continue;
+            const auto straight = dir == direction::EAST || dir == direction::WEST
+                                  ? extent(*previous % width, map.width()) : extent(*previous / width, map.height());
+            for (const auto entered : heat_loss_state_graph::all_directions) {
+                relax(*previous, entered, cost + (entered == dir ? straight : 1) * h.cheapest[*previous]);
+            }
+        }
+
+        h.exit_costs.assign(width * height * 4, unreachable);
+        for (std::size_t block = 0; block < width * height; ++block) {
+            for (const auto dir : heat_loss_state_graph::all_directions) {
+                if (const auto next = neighbor(block, dir)) {
+                    h.exit_costs[block * 4 + static_cast<std::size_t>(dir)]
+                            = entering[*next * 4 + static_cast<std::size_t>(dir)];
+                }
+            }
+        }
+        h.build_time = std::chrono::steady_clock::now() - start_time;
+        return h;
+    }
+
+    city_map_view map;
+    std::chrono::nanoseconds build_time{};
+
+private:
+    // far enough below the maximum that adding the way to the border cannot overflow
+    static constexpr unsigned unreachable = heat_loss_algorithm::maximal_heat_loss / 2;
+
+    struct level_cells {
+        std::size_t width;
+        std::size_t height;
+        std::vector<unsigned> cells;
+    };
+    std::vector<level_cells> levels;
+};
+
+// A* on the state graph guided by a cost pyramid. The stats report the time for the pyramid and its heuristic as
+// heuristic_time, and the estimate at the source as heuristic_estimate; expanded_nodes is counted in any build,
+// so that callers can compare it to a search without heuristic.
+struct heat_loss_algorithm_pyramid : heat_loss_algorithm {
+    using node = heat_loss_state_graph::node;
+    using index = heat_loss_state_graph::index;
+
+    heat_loss_state_graph graph;
+    heat_loss_query query;
+    cost_pyramid::heuristic h;
+    lazy_heat_loss_table heat_loss;
+    std::size_t expanded_nodes = 0;
+    mutable solver_stats stats;
+
+    heat_loss_algorithm_pyramid(const cost_pyramid &pyramid, const heat_loss_query &query, std::size_t level = 0)
+            : heat_loss_algorithm(pyramid.map), graph{pyramid.map}, query(query),
+              h(pyramid.heuristic_to(query.target, level)), heat_loss(graph.size()) {
+        check_position(map, query.source);
+        check_max_count(query);
+        stats.record(&solver_stats::heuristic_estimate, h(query.source));
+        if constexpr (solver_stats::enabled) {
+            stats.heuristic_time = pyramid.build_time + h.build_time;
+        }
+    }
+
+    unsigned run() {
+        return stats.time(&solver_stats::search_time, [this] {
+            auto search = make_state_graph_search(graph, heat_loss, search_direction::forward,
+                                                  [this](const node &n) { return h(n.pos); });
+            search.count_in(stats);
+            search.reach(heat_loss_state_graph::start_node(query.source), 0);
+            return search.run([this](const node &n, unsigned) {
+                ++expanded_nodes;
+                return n.pos == query.target;
+            });
+        });
+    }
+};
+
+inline unsigned minimal_heat_loss(const cost_pyramid &pyramid, const heat_loss_query &query) {
+    heat_loss_algorithm_pyramid algorithm{pyramid, query};
+    return algorithm.run();
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <array>
+#include <limits>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define AOC_HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#else
+#define AOC_HAVE_AVX2_KERNEL 0
+#endif
+
+// Heat loss per state in structure of arrays form: one plane per (direction, count), each with a border of
+// unreached cells around the map. All states of one kind along a row are then contiguous, so a row of cells can be
+// relaxed with SIMD lanes, and the border saves the bounds checks.
+class state_planes {
+public:
+    using position = city_map::position;
+    using node = heat_loss_algorithm_dijkstra::node;
+
+    // far enough below the maximum that adding one heat loss cannot overflow
+    static constexpr unsigned unreached = std::numeric_limits<unsigned>::max() / 2;
+    static constexpr std::size_t max_count = heat_loss_algorithm_dijkstra::step_history::max_count;
+    static constexpr std::size_t plane_count = 4 * max_count;
+
+    explicit state_planes(city_map_view map)
+            : map(map), padded_width(map.width() + 2), plane_size(padded_width * (map.height() + 2)),
+              values(plane_count * plane_size, unreached) {}
+
+    city_map_view map;
+
+    [[nodiscard]] unsigned *plane(direction dir, unsigned count) {
+        return values.data() + (static_cast<std::size_t>(dir) * max_count + count - 1) * plane_size;
+    }
+
+    [[nodiscard]] const unsigned *plane(direction dir, unsigned count) const {
+        return values.data() + (static_cast<std::size_t>(dir) * max_count + count - 1) * plane_size;
+    }
+
+    [[nodiscard]] std::size_t padded_index(const position &pos) const {
+        return (pos.y + 1) * padded_width + pos.x + 1;
+    }
+
+    // Offset within a plane to the cell a step in `dir` comes from
+    [[nodiscard]] std::ptrdiff_t from_offset(direction dir) const {
+        const auto row = static_cast<std::ptrdiff_t>(padded_width);
+        switch (dir) {
+            case direction::NORTH:
+                return row;
+            case direction::SOUTH:
+                return -row;
+            case direction::EAST:
+                return -1;
+            case direction::WEST:
+                return 1;
+        }
+        return 0;
+    }
+
+    void set(const node &n, unsigned heat_loss) {
+        plane(n.history.dir, n.history.count)[padded_index(n.pos)] = heat_loss;
+    }
+
+    // maximal_heat_loss if not reached
+    [[nodiscard]] unsigned get(const node &n) const {
+        const auto value = plane(n.history.dir, n.history.count)[padded_index(n.pos)];
+        return value == unreached ? heat_loss_algorithm::maximal_heat_loss : value;
+    }
+
+    [[nodiscard]] unsigned minimum_at(const position &pos) const {
+        unsigned minimum = heat_loss_algorithm::maximal_heat_loss;
+        for (auto dir : heat_loss_state_graph::all_directions) {
+            for (unsigned count = 1; count <= max_count; ++count) {
+                minimum = std::min(minimum, get(node{pos, {dir, count}}));
+            }
+        }
+        return minimum;
+    }
+
+private:
+    std::size_t padded_width;
+    std::size_t plane_size;
+    std::vector<unsigned> values;
+};
+
+enum class relax_kernel {
+    scalar,
+    avx2,
+};
+
+namespace relax_detail {
+
+// Cells [begin, end) of row y: every state takes the cheapest way to enter it from the cell behind it, i.e. a turn
+// from any state there for count 1, or the same direction with one less for the longer runs. Each plane is walked in
+// the direction of its runs, so that runs east and west both cross the whole row in one go.
+inline bool relax_row_scalar(state_planes &planes, std::size_t y, std::size_t begin, std::size_t end) {
+    const auto base = planes.padded_index({0, y});
+    bool changed = false;
+    for (auto dir : heat_loss_state_graph::all_directions) {
+        const auto from = planes.from_offset(dir);
+        const auto [left, right] = turns(dir);
+        for (std::size_t k = 0; k < end - begin; ++k) {
+            const auto x = dir == direction::WEST ? end - 1 - k : begin + k;
+            const auto i = base + x;
+            const auto w = planes.map.heat_loss({x, y});
+
+            unsigned turn = state_planes::unreached;
+            for (unsigned count = 1; count <= state_planes::max_count; ++count) {
+                turn = std::min({turn, planes.plane(left, count)[i + from], planes.plane(right, count)[i + from]});
+            }
+            unsigned previous = turn;
+            for (unsigned count = 1; count <= state_planes::max_count; ++count) {
+                auto &value = planes.plane(dir, count)[i];
+                const auto candidate = std::min(previous + w, state_planes::unreached);
+                previous = planes.plane(dir, count)[i + from];
+                if (candidate < value) {
+                    value = candidate;
+                    changed = true;
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+#if AOC_HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+inline __m256i load_lanes(const unsigned *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+// Same as relax_row_scalar for eight cells per instruction, with the blocks of eight in the direction of the runs.
+// The remaining cells are left to the scalar kernel.
+__attribute__((target("avx2")))
+inline std::size_t relax_row_avx2(state_planes &planes, std::size_t y, std::size_t begin, std::size_t end,
+                                  bool &changed) {
+    constexpr std::size_t lanes = 8;
+    const auto blocks = (end - begin) / lanes;
+    const auto vector_end = begin + blocks * lanes;
+    const auto base = planes.padded_index({0, y});
+    const auto *weights = planes.map.row_data(y);
+    const auto limit = _mm256_set1_epi32(static_cast<int>(state_planes::unreached));
+
+    __m256i any_change = _mm256_setzero_si256();
+    for (auto dir : heat_loss_state_graph::all_directions) {
+        const auto from = planes.from_offset(dir);
+        const auto [left, right] = turns(dir);
+        for (std::size_t block = 0; block < blocks; ++block) {
+            const auto x = begin + (dir == direction::WEST ? blocks - 1 - block : block) * lanes;
+            const auto i = base + x;
+            const auto w = load_lanes(weights + x);
+
+            auto previous = limit;
+            for (unsigned count = 1; count <= state_planes::max_count; ++count) {
+                previous = _mm256_min_epu32(previous, load_lanes(planes.plane(left, count) + i + from));
+                previous = _mm256_min_epu32(previous, load_lanes(planes.plane(right, count) + i + from));
+            }
+            for (unsigned count = 1; count <= state_planes::max_count; ++count) {
+                const auto value = load_lanes(planes.plane(dir, count) + i);
+                const auto candidate = _mm256_min_epu32(_mm256_add_epi32(previous, w), limit);
+                const auto relaxed = _mm256_min_epu32(value, candidate);
+                any_change = _mm256_or_si256(any_change,
+                                             _mm256_xor_si256(_mm256_cmpeq_epi32(relaxed, value),
+                                                              _mm256_set1_epi32(-1)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(planes.plane(dir, count) + i), relaxed);
+                previous = load_lanes(planes.plane(dir, count) + i + from);
+            }
+        }
+    }
+    changed = !_mm256_testz_si256(any_change, any_change);
+    return vector_end;
+}
+#endif
+
+}
+
+[[nodiscard]] inline bool avx2_available() {
+#if AOC_HAVE_AVX2_KERNEL
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+[[nodiscard]] inline relax_kernel best_relax_kernel() {
+    return avx2_available() ? relax_kernel::avx2 : relax_kernel::scalar;
+}
+
+// Relaxes all states of the cells [begin, end) of row y once from their neighbours. Returns whether any of them got
+// cheaper.
+inline bool relax_row(state_planes &planes, std::size_t y, std::size_t begin, std::size_t end,
+                      relax_kernel kernel = best_relax_kernel()) {
+    bool changed = false;
+#if AOC_HAVE_AVX2_KERNEL
+    if (kernel == relax_kernel::avx2) {
+        begin = relax_detail::relax_row_avx2(planes, y, begin, end, changed);
+    }
+#else
+    (void) kernel;
+#endif
+    return relax_detail::relax_row_scalar(planes, y, begin, end) || changed;
+}
+
+inline bool relax_row(state_planes &planes, std::size_t y, relax_kernel kernel = best_relax_kernel()) {
+    return relax_row(planes, y, 0, planes.map.width(), kernel);
+}
+
+enum class sweep_order {
+    top_down,
+    bottom_up,
+};
+
+// One pass over all rows. Runs southwards are carried through the whole map by a top down pass, runs northwards by
+// a bottom up one.
+inline bool relax_pass(state_planes &planes, relax_kernel kernel = best_relax_kernel(),
+                       sweep_order order = sweep_order::top_down) {
+    bool changed = false;
+    const auto rows = planes.map.height();
+    for (std::size_t i = 0; i < rows; ++i) {
+        const auto y = order == sweep_order::top_down ? i : rows - 1 - i;
+        changed = relax_row(planes, y, kernel) || changed;
+    }
+    return changed;
+}
@@ -0,0 +1,373 @@
+#include "aoc23.17.server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if AOC_NUMA
+#include <numa.h>
+#endif
+
+namespace solver_protocol {
+
+namespace {
+
+sockaddr_un socket_address(const std::string &socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument(std::format("socket path too long: {}", socket_path));
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+    return address;
+}
+
+}
+
+std::string encode_request(std::uint32_t id, const city_map &map, const heat_loss_query &query, map_format format) {
+    std::string payload;
+    if (format == map_format::text) {
+        payload.reserve((map.width() + 1) * map.height());
+        for (std::size_t y = 0; y < map.height(); ++y) {
+            for (std::size_t x = 0; x < map.width(); ++x) {
+                payload.push_back(static_cast<char>('0' + map.heat_loss({x, y})));
+            }
+            payload.push_back('\n');
+        }
+    } else {
+        payload.reserve(map.width() * map.height());
+        for (std::size_t y = 0; y < map.height(); ++y) {
+            for (std::size_t x = 0; x < map.width(); ++x) {
+                payload.push_back(static_cast<char>(map.heat_loss({x, y})));
+            }
+        }
+    }
+
+    request_header header{
+            .id = id,
+            .format = format,
+            .width = static_cast<std::uint32_t>(map.width()),
+            .height = static_cast<std::uint32_t>(map.height()),
+            .source_x = static_cast<std::uint32_t>(query.source.x),
+            .source_y = static_cast<std::uint32_t>(query.source.y),
+            .target_x = static_cast<std::uint32_t>(query.target.x),
+            .target_y = static_cast<std::uint32_t>(query.target.y),
+            .payload_size = static_cast<std::uint32_t>(payload.size()),
+    };
+    std::string request(sizeof(header), '\0');
+    std::memcpy(request.data(), &header, sizeof(header));
+    return request + payload;
+}
+
+std::uint64_t payload_limit(const request_header &header) {
+    const auto cells = std::uint64_t{header.width} * header.height;
+    switch (header.format) {
+        case map_format::text:
+            return cells + header.height;
+        case map_format::binary:
+            return cells;
+    }
+    return 0;
+}
+
+city_map decode_map(const request_header &header, std::string_view payload) {
+    // the header is checked against the payload before anything is allocated, so that a short request cannot
+    // make the server reserve memory for a huge map
+    const auto cells = std::uint64_t{header.width} * header.height;
+    const bool fits = header.format == map_format::binary
+                      ? cells == payload.size()
+                      : header.width <= payload.size() && cells <= payload.size();
+    if (!fits) {
+        throw std::invalid_argument(std::format("{} bytes for a {}x{} map",
+                                                payload.size(), header.width, header.height));
+    }
+
+    city_map map;
+    city_map::row row(header.width);
+
+    if (header.format == map_format::text) {
+        std::size_t start = 0;
+        while (start < payload.size()) {
+            auto end = payload.find('\n', start);
+            if (end == std::string_view::npos) end = payload.size();
+            const auto line = payload.substr(start, end - start);
+            start = end + 1;
+            if (line.empty()) continue;
+
+            if (line.size() != header.width) {
+                throw std::invalid_argument(std::format("line of length {} in map of width {}", line.size(), header.width));
+            }
+            std::transform(line.begin(), line.end(), row.begin(), [](char c) {
+                if (c < '0' || c > '9') {
+                    throw std::invalid_argument(std::format("invalid heat loss '{}'", c));
+                }
+                return static_cast<unsigned>(c - '0');
+            });
+            map.add_row(row);
+        }
+    } else if (header.format == map_format::binary) {
+        for (std::size_t y = 0; y < header.height; ++y) {
+            const auto line = payload.substr(y * header.width, header.width);
+            std::transform(line.begin(), line.end(), row.begin(), [](char c) { return static_cast<unsigned char>(c); });
+            map.add_row(row);
+        }
+    } else {
+        throw std::invalid_argument(std::format("unknown map format {}", static_cast<std::uint32_t>(header.format)));
+    }
+
+    if (map.height() != header.height) {
+        throw std::invalid_argument(std::format("{} rows in map of height {}", map.height(), header.height));
+    }
+    return map;
+}
+
+bool write_all(int fd, const void *data, std::size_t size) {
+    const auto *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        const auto written = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+bool read_all(int fd, void *data, std::size_t size) {
+    auto *bytes = static_cast<char *>(data);
+    while (size > 0) {
+        const auto received = ::recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        bytes += received;
+        size -= static_cast<std::size_t>(received);
+    }
+    return true;
+}
+
+int connect_to(const std::string &socket_path) {
+    const auto address = socket_address(socket_path);
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "socket");
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        const auto error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), std::format("connect to {}", socket_path));
+    }
+    return fd;
+}
+
+}
+
+struct solver_server::connection {
+    explicit connection(int fd) : fd(fd) {}
+    ~connection() { ::close(fd); }
+
+    bool send(const solver_protocol::response_header &response) {
+        std::lock_guard lock{write_mutex};
+        return solver_protocol::write_all(fd, &response, sizeof(response));
+    }
+
+    // Blocks while the connection has max_queued_per_connection queries waiting to be answered. Only the reader
+    // takes slots, so one is still free when it takes it after reading the next request.
+    void wait_for_slot() {
+        std::unique_lock lock{queue_mutex};
+        slot_free.wait(lock, [this] { return queued < max_queued_per_connection; });
+    }
+
+    void take_slot() {
+        std::lock_guard lock{queue_mutex};
+        ++queued;
+    }
+
+    void release_slot() {
+        {
+            std::lock_guard lock{queue_mutex};
+            --queued;
+        }
+        slot_free.notify_one();
+    }
+
+    int fd;
+    std::mutex write_mutex;
+    std::mutex queue_mutex;
+    std::condition_variable slot_free;
+    std::size_t queued = 0;
+};
+
+solver_server::solver_server(std::string socket_path, unsigned workers, page_mode pages)
+        : path(std::move(socket_path)), worker_count(std::max(1u, workers)), requested_pages(pages) {
+    // the state tables of a worker fall back the same way as this probe of a single huge page
+    obtained_pages = zeroed_buffer<char>(std::size_t{2} << 20, pages).obtained_pages();
+#if AOC_NUMA
+    if (numa_available() >= 0) {
+        numa_nodes = static_cast<unsigned>(numa_max_node() + 1);
+    }
+#endif
+
+    const auto address = solver_protocol::socket_address(path);
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "socket");
+    }
+    ::unlink(path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0
+        || ::listen(listen_fd, SOMAXCONN) != 0) {
+        const auto error = errno;
+        ::close(listen_fd);
+        throw std::system_error(error, std::generic_category(), std::format("listen on {}", path));
+    }
+}
+
+solver_server::~solver_server() {
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+    }
+    ::unlink(path.c_str());
+}
+
+std::string solver_server::memory_report() const {
+    const auto numa = numa_nodes == 0 ? std::string{"not available"}
+                                      : std::format("{} node(s), workers bound round robin", numa_nodes);
+    return std::format("pages: {} (requested {}), numa: {}", to_string(obtained_pages), to_string(requested_pages),
+                       numa);
+}
+
+void solver_server::stop() {
+    stopping = true;
+    ::shutdown(listen_fd, SHUT_RDWR);
+}
+
+void solver_server::run() {
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < worker_count; ++i) {
+        workers.emplace_back([this, i] { work(i); });
+    }
+
+    while (!stopping) {
+        const int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        auto client = std::make_shared<connection>(fd);
+        std::lock_guard lock{connections_mutex};
+        // the reader removes its connection when it is done, see read_requests()
+        std::thread([this, client] { read_requests(client); }).detach();
+        connections.push_back(std::move(client));
+    }
+
+    {
+        std::unique_lock lock{connections_mutex};
+        for (const auto &client : connections) {
+            ::shutdown(client->fd, SHUT_RD);
+        }
+        readers_done.wait(lock, [this] { return connections.empty(); });
+    }
+    {
+        std::lock_guard lock{jobs_mutex};
+        no_more_jobs = true;
+    }
+    jobs_available.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void solver_server::read_requests(const std::shared_ptr<connection> &client) {
+    using namespace solver_protocol;
+
+    request_header header;
+    while (true) {
+        client->wait_for_slot();
+        if (!read_all(client->fd, &header, sizeof(header))) {
+            break;
+        }
+        if (header.magic != request_magic || header.payload_size > max_payload_size
+            || header.payload_size > payload_limit(header)) {
+            client->send(response_header{.id = header.id, .result = status::invalid_request});
+            break;
+        }
+        // the payload only grows as fast as its bytes come in
+        std::string payload;
+        bool complete = true;
+        while (complete && payload.size() < header.payload_size) {
+            const auto offset = payload.size();
+            const auto chunk = std::min<std::size_t>(header.payload_size - offset, payload_chunk_size);
+            payload.resize(offset + chunk);
+            complete = read_all(client->fd, payload.data() + offset, chunk);
+        }
+        if (!complete) {
+            break;
+        }
+        client->take_slot();
+        {
+            std::lock_guard lock{jobs_mutex};
+            jobs.push_back(job{client, header, std::move(payload)});
+        }
+        jobs_available.notify_one();
+    }
+    // The socket is closed once the queued queries of this connection are answered. Notifying under the lock keeps
+    // run() from returning before this thread is done with the server.
+    std::lock_guard lock{connections_mutex};
+    std::erase(connections, client);
+    readers_done.notify_all();
+}
+
+std::size_t solver_server::open_connections() const {
+    std::lock_guard lock{connections_mutex};
+    return connections.size();
+}
+
+void solver_server::work([[maybe_unused]] unsigned worker_index) {
+#if AOC_NUMA
+    if (numa_nodes > 0) {
+        // first touch then places the lazily zeroed state tables on the worker's node
+        numa_run_on_node(static_cast<int>(worker_index % numa_nodes));
+        numa_set_localalloc();
+    }
+#endif
+    std::optional<heat_loss_algorithm_dijkstra> solver;
+    while (true) {
+        job next;
+        {
+            std::unique_lock lock{jobs_mutex};
+            jobs_available.wait(lock, [this] { return !jobs.empty() || no_more_jobs; });
+            if (jobs.empty()) return;
+            next = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        answer(next, solver);
+        ++answered_count;
+    }
+}
+
+void solver_server::answer(job &j, std::optional<heat_loss_algorithm_dijkstra> &solver) {
+    using namespace solver_protocol;
+
+    response_header response{.id = j.header.id};
+    try {
+        const auto map = decode_map(j.header, j.payload);
+        const city_map::position source{j.header.source_x, j.header.source_y};
+        if (solver) {
+            solver->reset(map, source);
+        } else {
+            solver.emplace(map, source, requested_pages);
+        }
+        response.heat_loss = minimal_heat_loss(*solver, {.source = source,
+                                                         .target = {j.header.target_x, j.header.target_y}});
+    } catch (const std::exception &) {
+        response.result = status::invalid_request;
+    }
+    j.client->send(response);
+    j.client->release_slot();
+}
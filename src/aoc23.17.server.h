@@ -0,0 +1,134 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Framing of the solver service on a local stream socket. A request is a header followed by the map payload, a
+// response is just a header. Requests carry an id chosen by the client, so that many of them can be in flight on
+// one connection and be answered out of order.
+namespace solver_protocol {
+
+enum class map_format : std::uint32_t {
+    text,   // rows of digits separated by newlines, like the puzzle input
+    binary, // one byte per cell, row major
+};
+
+enum class status : std::uint32_t {
+    ok,
+    invalid_request,
+};
+
+constexpr std::uint32_t request_magic = 0x51434f41;  // "AOCQ"
+constexpr std::uint32_t response_magic = 0x52434f41; // "AOCR"
+constexpr std::uint32_t max_payload_size = 1u << 30;
+// Payloads are read in pieces of this size as they arrive, so a header alone cannot make the server allocate much
+constexpr std::size_t payload_chunk_size = std::size_t{1} << 16;
+
+struct request_header {
+    std::uint32_t magic = request_magic;
+    std::uint32_t id = 0;
+    map_format format = map_format::binary;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint32_t source_x = 0;
+    std::uint32_t source_y = 0;
+    std::uint32_t target_x = 0;
+    std::uint32_t target_y = 0;
+    std::uint32_t payload_size = 0;
+};
+
+struct response_header {
+    std::uint32_t magic = response_magic;
+    std::uint32_t id = 0;
+    status result = status::ok;
+    std::uint32_t heat_loss = 0;
+};
+
+// Header and payload of a request, with the map encoded in the given format
+std::string encode_request(std::uint32_t id, const city_map &map, const heat_loss_query &query, map_format format);
+
+// The largest payload a map of the header's size and format can take: one byte per cell, plus a newline per row
+// in text format. Larger payloads are refused before they are read.
+std::uint64_t payload_limit(const request_header &header);
+
+// Throws std::invalid_argument if the payload does not match the header
+city_map decode_map(const request_header &header, std::string_view payload);
+
+// Blocking I/O on a socket, returning false on errors and end of stream
+bool write_all(int fd, const void *data, std::size_t size);
+bool read_all(int fd, void *data, std::size_t size);
+
+// Connected stream socket to a server, throws std::system_error
+int connect_to(const std::string &socket_path);
+
+}
+
+// Serves heat loss queries on a Unix domain socket. Every connection has a reader thread that only deframes
+// requests and cleans up after itself when the client hangs up; decoding and solving happens on a fixed pool of
+// workers that each keep one solver and reuse its state tables from query to query. A reader stops reading while
+// max_queued_per_connection queries of its connection wait to be answered. Responses are written as soon as their query is solved. With libnuma, the
+// workers are spread round robin over the NUMA nodes and allocate their state tables locally.
+class solver_server {
+public:
+    static constexpr std::size_t max_queued_per_connection = 64;
+
+    // Binds and listens right away, so clients can connect before run() is called
+    explicit solver_server(std::string socket_path, unsigned workers = std::thread::hardware_concurrency(),
+                           page_mode pages = page_mode::standard);
+    ~solver_server();
+
+    solver_server(const solver_server &) = delete;
+    solver_server &operator=(const solver_server &) = delete;
+
+    // Accepts connections until stop() is called, then waits for all queued queries to be answered
+    void run();
+    void stop();
+
+    [[nodiscard]] std::size_t answered() const { return answered_count; }
+    // Connections whose reader is still running
+    [[nodiscard]] std::size_t open_connections() const;
+
+    // Page mode the state tables actually get and how the workers are placed on NUMA nodes
+    [[nodiscard]] std::string memory_report() const;
+
+private:
+    struct connection;
+    struct job {
+        std::shared_ptr<connection> client;
+        solver_protocol::request_header header;
+        std::string payload;
+    };
+
+    void read_requests(const std::shared_ptr<connection> &client);
+    void work(unsigned worker_index);
+    void answer(job &j, std::optional<heat_loss_algorithm_dijkstra> &solver);
+
+    std::string path;
+    unsigned worker_count;
+    page_mode requested_pages;
+    page_mode obtained_pages = page_mode::standard;
+    unsigned numa_nodes = 0;
+    int listen_fd = -1;
+    std::atomic<bool> stopping = false;
+    std::atomic<std::size_t> answered_count = 0;
+
+    std::mutex jobs_mutex;
+    std::condition_variable jobs_available;
+    std::deque<job> jobs;
+    bool no_more_jobs = false;
+
+    mutable std::mutex connections_mutex;
+    std::condition_variable readers_done;
+    std::vector<std::shared_ptr<connection>> connections;
+};
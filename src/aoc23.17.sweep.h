@@ -0,0 +1,64 @@
+#pragma once
+
+#include "aoc23.17.h"
+#include "aoc23.17.relax.h"
+
+#include <cstddef>
+#include <optional>
+
+// Solves by relaxing all states over and over in alternating top down and bottom up passes until a pass changes
+// nothing, like Bellman-Ford. There is no queue and hardly a branch, but the number of passes grows with the number
+// of times the cheapest paths turn back north, so it suits maps where they mostly run downhill.
+struct heat_loss_algorithm_sweep : heat_loss_algorithm {
+    position source;
+    relax_kernel kernel;
+    state_planes planes;
+    std::size_t sweeps = 0;
+    bool converged = false;
+
+    explicit heat_loss_algorithm_sweep(city_map_view map, position source = initial_position,
+                                       relax_kernel kernel = best_relax_kernel())
+            : heat_loss_algorithm(map), source(source), kernel(kernel), planes(map) {
+        check_position(map, source);
+        planes.set(heat_loss_state_graph::start_node(source), 0);
+    }
+
+    explicit heat_loss_algorithm_sweep(city_map &&, position = initial_position,
+                                       relax_kernel = best_relax_kernel()) = delete;
+
+    // Every pass settles at least one more state along each cheapest path, so the number of states bounds the
+    // passes needed
+    [[nodiscard]] std::size_t default_max_sweeps() const {
+        return map.width() * map.height() * state_planes::plane_count;
+    }
+
+    // Sweeps until convergence or until max_sweeps passes in total were made, returns whether it converged. Can be
+    // called again to continue with a larger cap.
+    bool run(std::optional<std::size_t> max_sweeps = std::nullopt) {
+        const auto cap = max_sweeps.value_or(default_max_sweeps());
+        while (!converged && sweeps < cap) {
+            const auto order = sweeps % 2 == 0 ? sweep_order::top_down : sweep_order::bottom_up;
+            converged = !relax_pass(planes, kernel, order);
+            ++sweeps;
+        }
+        return converged;
+    }
+
+    // Exact once converged, otherwise the heat loss of the best path found so far
+    [[nodiscard]] unsigned get_minimal_heat_loss(const position &target) const {
+        check_position(map, target);
+        return planes.minimum_at(target);
+    }
+
+    [[nodiscard]] unsigned get_minimal_heat_loss() const {
+        return get_minimal_heat_loss(position{map.width() - 1, map.height() - 1});
+    }
+};
+
+inline unsigned minimal_heat_loss_sweep(city_map_view map, const heat_loss_query &query) {
+    check_position(map, query.target);
+    check_max_count(query);
+    heat_loss_algorithm_sweep algorithm{map, query.source};
+    algorithm.run();
+    return algorithm.get_minimal_heat_loss(query.target);
+}
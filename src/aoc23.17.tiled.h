@@ -0,0 +1,59 @@
+#pragma once
+
+#include "aoc23.17.h"
+
+#include <cstddef>
+#include <utility>
+
+// Heat loss of a tile copy that is moved tile_x + tile_y tiles away from the original: every tile adds one, and
+// values above 9 wrap around to 1
+struct wrapping_tile_increment {
+    [[nodiscard]] unsigned operator()(unsigned heat_loss, std::size_t tile_x, std::size_t tile_y) const {
+        const auto value = heat_loss + static_cast<unsigned>(tile_x + tile_y);
+        return value > 9 ? (value - 1) % 9 + 1 : value;
+    }
+};
+
+// A base map repeated tiles_x times to the right and tiles_y times downwards, each copy with its heat losses passed
+// through transform(heat_loss, tile_x, tile_y). Nothing of the expansion is stored, a cell is computed whenever it
+// is read, so a view onto a 141x141 map tiled 100x100 still takes a few words. Like city_map_view it only refers to
+// the base map, which has to outlive it.
+template<typename Transform = wrapping_tile_increment>
+class tiled_city_map {
+public:
+    using position = city_map::position;
+
+    tiled_city_map(city_map_view base, std::size_t tiles_x, std::size_t tiles_y, Transform transform = {})
+            : base(base), tiles_x(tiles_x), tiles_y(tiles_y), transform(std::move(transform)) {}
+
+    // the view only refers to the base map, so it must not be built on a temporary one
+    tiled_city_map(city_map &&, std::size_t, std::size_t, Transform = {}) = delete;
+
+    [[nodiscard]] std::size_t width() const { return base.width() * tiles_x; }
+    [[nodiscard]] std::size_t height() const { return base.height() * tiles_y; }
+
+    [[nodiscard]] unsigned heat_loss(const position &p) const {
+        const auto tile_x = p.x / base.width();
+        const auto tile_y = p.y / base.height();
+        return transform(base.heat_loss({p.x - tile_x * base.width(), p.y - tile_y * base.height()}), tile_x, tile_y);
+    }
+
+private:
+    city_map_view base;
+    std::size_t tiles_x;
+    std::size_t tiles_y;
+    Transform transform;
+};
+
+// Stores the cells of any map, for the solvers that only take a city_map_view
+inline city_map to_city_map(const heat_loss_map auto &map) {
+    city_map result;
+    city_map::row r(map.width());
+    for (std::size_t y = 0; y < map.height(); ++y) {
+        for (std::size_t x = 0; x < map.width(); ++x) {
+            r[x] = map.heat_loss({x, y});
+        }
+        result.add_row(r);
+    }
+    return result;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "aoc23.17.h"
+#include "aoc23.17.relax.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <cstddef>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Sweeps the state planes like heat_loss_algorithm_sweep, but each pass runs diagonally from one corner of the map
+// to the opposite one, and the passes take turns among the four corners. In a pass from the top left, a cell pulls
+// its eastward and southward runs from the cells to its left and above, which are on the previous anti-diagonal, so
+// all cells of one anti-diagonal can be relaxed at the same time. The map is cut into square tiles, and the tiles of
+// one diagonal are spread over the threads, which wait for each other at the end of every diagonal. Within a tile the
+// rows are taken in the vertical direction of the pass, each with the row kernel of the sweep, which carries runs
+// east and west across the whole tile whatever the corner. Tiles on the same diagonal only touch at corners, so the threads never read what another one writes.
+// run() starts its own threads rather than using a pool like the thread_pool_executor of solve_async(). They stay for
+// all passes of the run, so starting them costs far less than the first pass, and the threads wait for each other at
+// every diagonal, which would deadlock a shared pool with fewer idle threads than the run needs.
+struct heat_loss_algorithm_wavefront : heat_loss_algorithm {
+    position source;
+    unsigned threads;
+    std::size_t tile_size;
+    relax_kernel kernel;
+    state_planes planes;
+    std::size_t sweeps = 0;
+    bool converged = false;
+
+    explicit heat_loss_algorithm_wavefront(city_map_view map, position source = initial_position,
+                                           unsigned threads = std::thread::hardware_concurrency(),
+                                           std::size_t tile_size = 32, relax_kernel kernel = best_relax_kernel())
+            : heat_loss_algorithm(map), source(source), threads(std::max(1u, threads)),
+              tile_size(std::max<std::size_t>(1, tile_size)), kernel(kernel), planes(map) {
+        check_position(map, source);
+        planes.set(heat_loss_state_graph::start_node(source), 0);
+    }
+
+    explicit heat_loss_algorithm_wavefront(city_map &&, position = initial_position, unsigned = 1,
+                                           std::size_t = 32, relax_kernel = best_relax_kernel()) = delete;
+
+    [[nodiscard]] std::size_t default_max_sweeps() const {
+        return map.width() * map.height() * state_planes::plane_count;
+    }
+
+    // Sweeps until convergence or until max_sweeps passes in total were made, returns whether it converged. Can be
+    // called again to continue with a larger cap.
+    bool run(std::optional<std::size_t> max_sweeps = std::nullopt) {
+        const auto cap = max_sweeps.value_or(default_max_sweeps());
+        if (converged || sweeps >= cap) return converged;
+
+        const auto tiles_x = (map.width() + tile_size - 1) / tile_size;
+        const auto tiles_y = (map.height() + tile_size - 1) / tile_size;
+        const auto diagonals = tiles_x + tiles_y - 1;
+        // Whether a pass changed anything, the flag of a pass being cleared two passes before: all threads read it
+        // at the end of the pass that used it last, and each pass ends with all threads meeting at a barrier
+        std::array<std::atomic<bool>, 3> changed{false, false, false};
+        std::barrier sync(static_cast<std::ptrdiff_t>(threads));
+
+        const auto work = [&](unsigned thread) {
+            for (auto pass = sweeps; pass < cap; ++pass) {
+                if (thread == 0) changed[(pass + 1) % 3] = false;
+                const auto corner = pass % 4;
+                const bool east = corner == 0 || corner == 2;
+                const bool south = corner == 0 || corner == 3;
+                for (std::size_t diagonal = 0; diagonal < diagonals; ++diagonal) {
+                    // the tiles (i, diagonal - i) counted from the corner the pass starts at
+                    const auto first = diagonal < tiles_y ? 0 : diagonal - tiles_y + 1;
+                    const auto last = std::min(diagonal, tiles_x - 1);
+                    bool any = false;
+                    for (auto i = first + thread; i <= last; i += threads) {
+                        const auto tile_x = east ? i : tiles_x - 1 - i;
+                        const auto tile_y = south ? diagonal - i : tiles_y - 1 - (diagonal - i);
+                        any = relax_tile(tile_x, tile_y, south) || any;
+                    }
+                    if (any) changed[pass % 3] = true;
+                    sync.arrive_and_wait();
+                }
+                if (thread == 0) sweeps = pass + 1;
+                if (!changed[pass % 3]) {
+                    if (thread == 0) converged = true;
+                    return;
+                }
+            }
+        };
+
+        std::vector<std::jthread> pool;
+        for (unsigned t = 1; t < threads; ++t) {
+            pool.emplace_back(work, t);
+        }
+        work(0);
+        return converged;
+    }
+
+    // Exact once converged, otherwise the heat loss of the best path found so far
+    [[nodiscard]] unsigned get_minimal_heat_loss(const position &target) const {
+        check_position(map, target);
+        return planes.minimum_at(target);
+    }
+
+    [[nodiscard]] unsigned get_minimal_heat_loss() const {
+        return get_minimal_heat_loss(position{map.width() - 1, map.height() - 1});
+    }
+
+private:
+    bool relax_tile(std::size_t tile_x, std::size_t tile_y, bool south) {
+        const auto x_begin = tile_x * tile_size;
+        const auto x_end = std::min(x_begin + tile_size, map.width());
+        const auto y_begin = tile_y * tile_size;
+        const auto y_end = std::min(y_begin + tile_size, map.height());
+        bool changed = false;
+        for (auto i = y_begin; i < y_end; ++i) {
+            const auto y = south ? i : y_begin + y_end - 1 - i;
+            changed = relax_row(planes, y, x_begin, x_end, kernel) || changed;
+        }
+        return changed;
+    }
+};
+
+inline unsigned minimal_heat_loss_wavefront(city_map_view map, const heat_loss_query &query,
+                                            unsigned threads = std::thread::hardware_concurrency()) {
+    check_position(map, query.target);
+    check_max_count(query);
+    heat_loss_algorithm_wavefront algorithm{map, query.source, threads};
+    algorithm.run();
+    return algorithm.get_minimal_heat_loss(query.target);
+}
@@ -1,9 +1,58 @@
 #include "aoc23.17.h"
+#if AOC_SERVER
+#include "aoc23.17.server.h"
+#endif
 #include <fstream>
 #include <format>
 #include <iostream>
+#include <string>
+#include <string_view>
+
+// --huge-pages or --hugetlb anywhere on the command line
+static page_mode requested_pages(int argc, char *argv[]) {
+    auto pages = page_mode::standard;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string_view{argv[i]} == "--huge-pages") pages = page_mode::transparent_huge;
+        if (std::string_view{argv[i]} == "--hugetlb") pages = page_mode::huge_tlb;
+    }
+    return pages;
+}
+
+// --stats anywhere on the command line
+static bool requested_stats(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::string_view{argv[i]} == "--stats") return true;
+    }
+    return false;
+}
+
+int main(int argc, char *argv[]) {
+    const auto pages = requested_pages(argc, argv);
+    if (argc > 1 && std::string_view{argv[1]} == "--serve") {
+#if AOC_SERVER
+        if (argc == 2 || std::string_view{argv[2]}.starts_with("--")) {
+            std::cerr << "usage: " << argv[0] << " --serve <socket> [workers] [--huge-pages | --hugetlb]\n";
+            return 1;
+        }
+        const bool workers_given = argc > 3 && !std::string_view{argv[3]}.starts_with("--");
+        const unsigned workers = workers_given ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+        solver_server server{argv[2], workers, pages};
+        std::cout << std::format("serving on {} with {} workers, {}\n", argv[2], workers, server.memory_report())
+                  << std::flush;
+        server.run();
+        return 0;
+#else
+        std::cerr << "--serve is only available on POSIX systems\n";
+        return 1;
+#endif
+    }
+
+    const bool print_stats = requested_stats(argc, argv);
+    if (print_stats && !solver_stats::enabled) {
+        std::cerr << "--stats needs a build with AOC_SOLVER_STATS=ON\n";
+        return 1;
+    }
 
-int main() {
     city_map map;
 
     std::ifstream input("src/aoc23.17.input.txt");
@@ -20,6 +69,15 @@ int main() {
     }
     std::cout << std::format("Width = {}, height = {}", map.width(), map.height());
 
-    std::cout << std::format("minimal heat loss: {}", minimal_heat_loss(map));
-}
+    const auto query = heat_loss_query::whole_map(map);
+    // kept for its stats and page mode
+    heat_loss_algorithm_dijkstra algorithm{map, query.source, pages};
+    std::cout << std::format("minimal heat loss: {}", minimal_heat_loss(algorithm, query));
 
+    if (pages != page_mode::standard) {
+        std::cout << std::format("\npages: {} (requested {})", to_string(algorithm.obtained_pages()), to_string(pages));
+    }
+    if (print_stats) {
+        std::cout << '\n' << algorithm.stats.to_json() << '\n';
+    }
+}
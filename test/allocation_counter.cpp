@@ -0,0 +1,35 @@
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<std::size_t> allocations{0};
+std::atomic<std::size_t> bytes{0};
+}
+
+std::size_t allocation_count() {
+    return allocations.load();
+}
+
+std::size_t allocated_bytes() {
+    return bytes.load();
+}
+
+void *operator new(std::size_t size) {
+    ++allocations;
+    bytes += size;
+    if (void *p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+
+// Counts calls to the global operator new of the test program, to check that code paths do not allocate.
+std::size_t allocation_count();
+// Total size requested from it so far
+std::size_t allocated_bytes();
@@ -0,0 +1,51 @@
+#include "aoc23.17.h"
+#include "aoc23.17.alt.h"
+#include "aoc23.17.generate.h"
+
+#include "catch.hpp"
+
+TEST_CASE("alt landmarks") {
+    const auto map = random_city_map(30, 25);
+
+    SECTION("corners first, then farthest points") {
+        const auto landmarks = alt_landmarks::compute(map, 6, 2);
+        const auto chosen = landmarks.landmarks();
+        REQUIRE(chosen.size() == 6);
+        CHECK((chosen[0] == city_map::position{0, 0}));
+        CHECK((chosen[1] == city_map::position{29, 24}));
+        CHECK(std::ranges::find(chosen, chosen[4]) == chosen.begin() + 4);
+        CHECK(landmarks.memory_bytes() == 6 * 2 * (30 * 25 + 30 * 25 * 12) * sizeof(alt_landmarks::distance));
+    }
+    SECTION("exact for any query") {
+        const auto landmarks = alt_landmarks::compute(map, 6);
+        for (const auto &query : {heat_loss_query::whole_map(map),
+                                  heat_loss_query{.source = {20, 3}, .target = {4, 17}},
+                                  heat_loss_query{.source = {7, 7}, .target = {8, 20}}}) {
+            CHECK(minimal_heat_loss(landmarks, query) == minimal_heat_loss(map, query));
+        }
+    }
+    SECTION("heuristic is a lower bound") {
+        const auto landmarks = alt_landmarks::compute(map, 4);
+        const city_map::position target{4, 17};
+        const auto h = landmarks.heuristic_to(target);
+        for (const auto source : {city_map::position{20, 3}, city_map::position{29, 24}, city_map::position{4, 16}}) {
+            CHECK(h(heat_loss_state_graph::start_node(source))
+                  <= minimal_heat_loss(map, {.source = source, .target = target}));
+        }
+        CHECK(h(heat_loss_state_graph::start_node(target)) == 0);
+    }
+    SECTION("expands fewer states than without landmarks") {
+        const heat_loss_query query{.source = {20, 3}, .target = {4, 17}};
+        const auto guided = alt_search(alt_landmarks::compute(map, 8), query);
+        const auto blind = alt_search(alt_landmarks::compute(map, 0), query);
+        CHECK(guided.heat_loss == blind.heat_loss);
+        CHECK(guided.expanded_nodes < blind.expanded_nodes);
+    }
+    SECTION("rejects bad queries") {
+        const auto landmarks = alt_landmarks::compute(map, 2);
+        CHECK_THROWS_AS(alt_search(landmarks, {.source = {30, 0}, .target = {4, 17}}), const std::out_of_range &);
+        CHECK_THROWS_AS(alt_search(landmarks, {.source = {0, 0}, .target = {4, 25}}), const std::out_of_range &);
+        CHECK_THROWS_AS(alt_search(landmarks, {.source = {0, 0}, .target = {4, 17}, .max_count = 10}),
+                        const std::invalid_argument &);
+    }
+}
@@ -0,0 +1,43 @@
+#include "aoc23.17.h"
+#include "aoc23.17.anytime.h"
+#include "aoc23.17.generate.h"
+
+#include "catch.hpp"
+
+TEST_CASE("anytime search") {
+    const auto map = random_city_map(30, 25);
+    const auto query = heat_loss_query::whole_map(map);
+    const auto exact = minimal_heat_loss(map);
+
+    SECTION("is exact without a budget") {
+        const auto result = minimal_heat_loss_anytime(map, query);
+        CHECK(result.exact());
+        CHECK(result.upper_bound == exact);
+    }
+    SECTION("brackets the optimum with a node budget") {
+        for (const std::size_t max_nodes : {10, 500, 3000, 8000}) {
+            const auto result = minimal_heat_loss_anytime(map, query, {.max_nodes = max_nodes});
+            CHECK(result.lower_bound <= exact);
+            CHECK(result.upper_bound >= exact);
+        }
+    }
+    SECTION("finds a path early") {
+        const auto result = minimal_heat_loss_anytime(map, query, {.max_nodes = 500});
+        CHECK(result.upper_bound != heat_loss_algorithm::maximal_heat_loss);
+        CHECK_FALSE(result.exact());
+    }
+    SECTION("other source and target") {
+        const heat_loss_query inner{.source = {20, 3}, .target = {4, 17}};
+        const auto result = minimal_heat_loss_anytime(map, inner);
+        CHECK(result.exact());
+        CHECK(result.upper_bound == minimal_heat_loss(map, inner));
+    }
+    SECTION("rejects bad queries") {
+        CHECK_THROWS_AS(minimal_heat_loss_anytime(map, {.source = {30, 0}, .target = {4, 17}}),
+                        const std::out_of_range &);
+        CHECK_THROWS_AS(minimal_heat_loss_anytime(map, {.source = {20, 3}, .target = {4, 25}}),
+                        const std::out_of_range &);
+        CHECK_THROWS_AS(minimal_heat_loss_anytime(map, {.target = {4, 17}, .max_count = 10}),
+                        const std::invalid_argument &);
+    }
+}
@@ -0,0 +1,66 @@
+#include "aoc23.17.h"
+#include "aoc23.17.async.h"
+#include "aoc23.17.generate.h"
+
+#include "catch.hpp"
+
+#include <chrono>
+#include <stop_token>
+#include <vector>
+
+TEST_CASE("solve_async") {
+    const auto map = random_city_map(20, 20);
+    const auto expected = minimal_heat_loss(map);
+
+    SECTION("on the calling thread") {
+        inline_executor here;
+        CHECK(sync_wait(solve_async(map, heat_loss_query::whole_map(map), {.on = &here})) == expected);
+    }
+    SECTION("on a thread pool") {
+        thread_pool_executor pool{2};
+        CHECK(sync_wait(solve_async(map, heat_loss_query::whole_map(map), {.on = &pool})) == expected);
+    }
+    SECTION("many queries at once") {
+        thread_pool_executor pool{2};
+        std::vector<city_map> maps;
+        std::vector<unsigned> expected_results;
+        for (unsigned seed = 0; seed < 10; ++seed) {
+            maps.push_back(random_city_map(12, 9, seed));
+            expected_results.push_back(minimal_heat_loss(maps.back()));
+        }
+        std::vector<task<unsigned>> queries;
+        for (const auto &m : maps) {
+            queries.push_back(solve_async(m, heat_loss_query::whole_map(m), {.on = &pool}));
+        }
+        CHECK(sync_wait(when_all(std::move(queries))) == expected_results);
+    }
+    SECTION("cancelled") {
+        inline_executor here;
+        std::stop_source stop;
+        stop.request_stop();
+        CHECK_THROWS_AS(sync_wait(solve_async(map, heat_loss_query::whole_map(map), {.on = &here, .stop = stop.get_token()})),
+                        const solve_interrupted &);
+    }
+    SECTION("past the deadline") {
+        inline_executor here;
+        const auto deadline = std::chrono::steady_clock::now() - std::chrono::seconds{1};
+        CHECK_THROWS_AS(sync_wait(solve_async(map, heat_loss_query::whole_map(map), {.on = &here, .deadline = deadline})),
+                        const solve_interrupted &);
+    }
+    SECTION("rejects bad queries before it starts") {
+        inline_executor here;
+        CHECK_THROWS_AS(solve_async(map, {.source = {20, 0}, .target = {3, 3}}, {.on = &here}), const std::out_of_range &);
+        CHECK_THROWS_AS(solve_async(map, {.source = {0, 0}, .target = {3, 20}}, {.on = &here}), const std::out_of_range &);
+        CHECK_THROWS_AS(solve_async(map, {.source = {0, 0}, .target = {3, 3}, .max_count = 10}, {.on = &here}),
+                        const std::invalid_argument &);
+    }
+}
+
+TEST_CASE("run_dijkstra can be interrupted") {
+    const auto map = random_city_map(40, 40);
+    heat_loss_algorithm_dijkstra algorithm{map};
+    unsigned checks = 0;
+    CHECK_FALSE(algorithm.run_dijkstra([&checks] { return ++checks == 2; }));
+    CHECK(checks == 2);
+    CHECK_FALSE(algorithm.queue.empty());
+}
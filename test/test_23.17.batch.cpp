@@ -0,0 +1,117 @@
+#include "aoc23.17.h"
+#include "aoc23.17.batch.h"
+#include "aoc23.17.generate.h"
+
+#include "catch.hpp"
+
+#include <vector>
+
+namespace {
+
+std::vector<city_map> random_maps(std::size_t count, std::size_t width, std::size_t height) {
+    std::vector<city_map> maps;
+    for (std::size_t i = 0; i < count; ++i) {
+        maps.push_back(random_city_map(width, height, static_cast<unsigned>(i + 1)));
+    }
+    return maps;
+}
+
+template<typename Batch>
+void check_batch_engine() {
+    SECTION("full batch, both kernels") {
+        const auto maps = random_maps(Batch::lanes, 30, 25);
+        const std::vector<city_map_view> views(maps.begin(), maps.end());
+        for (const auto kernel : {relax_kernel::scalar, relax_kernel::avx2}) {
+            if (kernel == relax_kernel::avx2 && !avx2_available()) continue;
+            Batch batch{views, heat_loss_algorithm::initial_position, kernel};
+            CHECK(batch.size() == Batch::lanes);
+            CHECK(batch.run());
+            for (std::size_t i = 0; i < maps.size(); ++i) {
+                CHECK(batch.get_minimal_heat_loss(i) == minimal_heat_loss(maps[i]));
+            }
+        }
+    }
+    SECTION("partial batch of different maps") {
+        std::vector<city_map> maps{serpentine_city_map(40, 20), random_city_map(40, 20)};
+        const std::vector<city_map_view> views(maps.begin(), maps.end());
+        Batch batch{views};
+        CHECK(batch.run());
+        CHECK(batch.get_minimal_heat_loss(0) == minimal_heat_loss(maps[0]));
+        CHECK(batch.get_minimal_heat_loss(1) == minimal_heat_loss(maps[1]));
+        CHECK_THROWS_AS(batch.get_minimal_heat_loss(2), const std::out_of_range &);
+    }
+    SECTION("other source and target") {
+        const auto maps = random_maps(3, 30, 25);
+        const std::vector<city_map_view> views(maps.begin(), maps.end());
+        const heat_loss_query query{.source = {20, 3}, .target = {4, 17}};
+        Batch batch{views, query.source};
+        CHECK(batch.run());
+        for (std::size_t i = 0; i < maps.size(); ++i) {
+            CHECK(batch.get_minimal_heat_loss(i, query.target) == minimal_heat_loss(maps[i], query));
+        }
+    }
+    SECTION("sweep cap") {
+        const auto map = serpentine_city_map(40, 20);
+        const std::vector<city_map_view> views{map};
+        Batch batch{views};
+        CHECK_FALSE(batch.run(2));
+        CHECK(batch.sweeps == 2);
+        CHECK(batch.get_minimal_heat_loss(0) >= minimal_heat_loss(map));
+        CHECK(batch.run());
+        CHECK(batch.get_minimal_heat_loss(0) == minimal_heat_loss(map));
+    }
+    SECTION("invalid batches") {
+        const auto maps = random_maps(Batch::lanes + 1, 10, 10);
+        const std::vector<city_map_view> views(maps.begin(), maps.end());
+        CHECK_THROWS_AS(Batch(std::span(views).first(0)), const std::invalid_argument &);
+        CHECK_THROWS_AS(Batch(views), const std::invalid_argument &);
+
+        const auto other = random_city_map(11, 10);
+        const std::vector<city_map_view> mixed{maps[0], other};
+        CHECK_THROWS_AS(Batch(mixed), const std::invalid_argument &);
+        CHECK_THROWS_AS(Batch(std::span(views).first(1), {10, 0}), const std::out_of_range &);
+    }
+}
+
+}
+
+TEST_CASE("batch engine, 32 bit lanes") {
+    check_batch_engine<heat_loss_batch>();
+}
+
+TEST_CASE("batch engine, 16 bit lanes") {
+    check_batch_engine<heat_loss_batch16>();
+}
+
+TEST_CASE("batch engine lane width") {
+    CHECK(heat_loss_batch16::fits(141, 141, 9));
+    CHECK_FALSE(heat_loss_batch16::fits(1000, 1000, 9));
+    CHECK(heat_loss_batch::fits(1000, 1000, 9));
+
+    city_map map;
+    map.add_row(city_map::row(5, 4000));
+    map.add_row(city_map::row(5, 4000));
+    const std::vector<city_map_view> views{map};
+    CHECK_THROWS_AS(heat_loss_batch16(views), const std::invalid_argument &);
+
+    const std::vector<city_map> maps{map, map};
+    const auto query = heat_loss_query::whole_map(map);
+    const std::vector<unsigned> expected{minimal_heat_loss(map), minimal_heat_loss(map)};
+    CHECK(minimal_heat_loss_batch(maps, query) == expected);
+}
+
+TEST_CASE("batched solving") {
+    const auto maps = random_maps(20, 30, 25);
+    const auto query = heat_loss_query::whole_map(maps.front());
+    const auto result = minimal_heat_loss_batch(maps, query);
+    REQUIRE(result.size() == maps.size());
+    for (std::size_t i = 0; i < maps.size(); ++i) {
+        CHECK(result[i] == minimal_heat_loss(maps[i]));
+    }
+    CHECK(minimal_heat_loss_batch(std::span<const city_map>{}, query).empty());
+
+    // the last map would be alone in a second batch
+    auto mixed = random_maps(17, 30, 25);
+    mixed.push_back(random_city_map(300, 300));
+    CHECK_THROWS_AS(minimal_heat_loss_batch(mixed, query), const std::invalid_argument &);
+}
@@ -0,0 +1,99 @@
+#include "aoc23.17.h"
+#include "aoc23.17.cache.h"
+#include "aoc23.17.generate.h"
+
+#include "allocation_counter.h"
+#include "catch.hpp"
+
+TEST_CASE("content_hash") {
+    const auto map = random_city_map(20, 10);
+
+    SECTION("depends on content") {
+        auto other = map;
+        CHECK(other.content_hash() == map.content_hash());
+        other.set_heat_loss({3, 4}, map.heat_loss({3, 4}) % 9 + 1);
+        CHECK(other.content_hash() != map.content_hash());
+        other.set_heat_loss({3, 4}, map.heat_loss({3, 4}));
+        CHECK(other.content_hash() == map.content_hash());
+    }
+    SECTION("kept up to date by changes") {
+        auto changed = map;
+        changed.set_heat_loss({7, 2}, map.heat_loss({7, 2}) % 9 + 1);
+        city_map loaded;
+        for (std::size_t y = 0; y < changed.height(); ++y) {
+            city_map::row r;
+            for (std::size_t x = 0; x < changed.width(); ++x) {
+                r.push_back(changed.heat_loss({x, y}));
+            }
+            loaded.add_row(r);
+        }
+        CHECK(loaded.content_hash() == changed.content_hash());
+    }
+    SECTION("depends on the order of rows") {
+        city_map one;
+        one.add_row({1, 2});
+        one.add_row({3, 4});
+        city_map other;
+        other.add_row({3, 4});
+        other.add_row({1, 2});
+        CHECK(one.content_hash() != other.content_hash());
+    }
+    SECTION("depends on dimensions") {
+        city_map wide;
+        wide.add_row({1, 2, 3, 4});
+        city_map narrow;
+        narrow.add_row({1, 2});
+        narrow.add_row({3, 4});
+        CHECK(wide.content_hash() != narrow.content_hash());
+    }
+}
+
+TEST_CASE("heat_loss_cache") {
+    heat_loss_cache cache{1 << 20};
+    const auto map = random_city_map(15, 15);
+    const auto expected = minimal_heat_loss(map);
+
+    SECTION("counts hits and misses") {
+        CHECK(minimal_heat_loss(cache, map) == expected);
+        CHECK(minimal_heat_loss(cache, map) == expected);
+        CHECK(minimal_heat_loss(cache, random_city_map(15, 15, 4711)) != 0);
+        CHECK(cache.hits() == 1);
+        CHECK(cache.misses() == 2);
+        CHECK(cache.size() == 2);
+    }
+    SECTION("evicts least recently used") {
+        heat_loss_cache small{2 * heat_loss_cache::bytes_per_entry};
+        REQUIRE(small.max_size() == 2);
+        const heat_loss_cache::key a{1, {}};
+        const heat_loss_cache::key b{2, {}};
+        const heat_loss_cache::key c{3, {}};
+        CHECK(small.get_or_solve(a, [] { return 10u; }) == 10);
+        CHECK(small.get_or_solve(b, [] { return 20u; }) == 20);
+        // the hit makes b the least recently used entry
+        CHECK(small.get_or_solve(a, [] { return 11u; }) == 10);
+        CHECK(small.get_or_solve(c, [] { return 30u; }) == 30);
+        CHECK(small.size() == 2);
+        CHECK(small.misses() == 3);
+
+        CHECK(small.get_or_solve(a, [] { return 12u; }) == 10);
+        CHECK(small.hits() == 2);
+        CHECK(small.get_or_solve(b, [] { return 21u; }) == 21);
+        CHECK(small.misses() == 4);
+    }
+    SECTION("queries with source and target") {
+        const heat_loss_query query{.source = {3, 2}, .target = {11, 9}};
+        const auto partial = minimal_heat_loss(map, query);
+        CHECK(minimal_heat_loss(cache, map, query) == partial);
+        CHECK(minimal_heat_loss(cache, map) == expected);
+        CHECK(minimal_heat_loss(cache, map, query) == partial);
+        CHECK(cache.hits() == 1);
+        CHECK(cache.misses() == 2);
+    }
+    SECTION("hit does not allocate") {
+        minimal_heat_loss(cache, map);
+        const auto allocations_before = allocation_count();
+        const auto result = minimal_heat_loss(cache, map);
+        CHECK(allocation_count() == allocations_before);
+        CHECK(result == expected);
+    }
+}
@@ -0,0 +1,88 @@
+#include "aoc23.17.h"
+#include "aoc23.17.ch.h"
+#include "aoc23.17.generate.h"
+
+#include <cstring>
+#include <sstream>
+
+#include "catch.hpp"
+
+TEST_CASE("contraction hierarchy") {
+    const auto map = random_city_map(20, 15);
+    const auto hierarchy = contraction_hierarchy::compute(map, 2);
+
+    SECTION("exact for any query") {
+        contraction_hierarchy_query query{hierarchy};
+        for (const auto &q : {heat_loss_query::whole_map(map),
+                              heat_loss_query{.source = {17, 3}, .target = {4, 12}},
+                              heat_loss_query{.source = {7, 7}, .target = {8, 14}},
+                              heat_loss_query{.source = {19, 14}, .target = {0, 0}},
+                              heat_loss_query{.source = {5, 5}, .target = {5, 5}}}) {
+            CHECK(query.run(q) == minimal_heat_loss(map, q));
+        }
+        CHECK(query.settled_nodes < hierarchy.node_count() / 4);
+    }
+    SECTION("same hierarchy on one thread") {
+        const auto serial = contraction_hierarchy::compute(map, 1);
+        CHECK(minimal_heat_loss(serial, heat_loss_query::whole_map(map)) == minimal_heat_loss(map));
+    }
+    SECTION("saved and loaded") {
+        std::stringstream stream;
+        hierarchy.save(stream);
+        const auto loaded = contraction_hierarchy::load(stream, map);
+        CHECK(loaded.edge_count() == hierarchy.edge_count());
+        const heat_loss_query q{.source = {17, 3}, .target = {4, 12}};
+        CHECK(minimal_heat_loss(loaded, q) == minimal_heat_loss(map, q));
+    }
+    SECTION("is only loaded for its map") {
+        std::stringstream stream;
+        hierarchy.save(stream);
+        auto other = map;
+        other.set_heat_loss({3, 3}, map.heat_loss({3, 3}) % 9 + 1);
+        CHECK_THROWS_AS(contraction_hierarchy::load(stream, other), const std::runtime_error &);
+
+        std::stringstream truncated{stream.str().substr(0, 100)};
+        CHECK_THROWS_AS(contraction_hierarchy::load(truncated, map), const std::runtime_error &);
+    }
+    SECTION("rejects damaged files") {
+        std::stringstream stream;
+        hierarchy.save(stream);
+        const auto saved = stream.str();
+        // header: magic, width, height and version of 32 bits, then forward and backward edge counts and map hash
+        // of 64 bits
+        constexpr std::size_t version_at = 12;
+        constexpr std::size_t forward_count_at = 16;
+        constexpr std::size_t header_size = 40;
+        const auto offsets_size = (hierarchy.node_count() + 1) * sizeof(std::uint64_t);
+
+        auto old_version = saved;
+        const std::uint32_t version = 1;
+        std::memcpy(old_version.data() + version_at, &version, sizeof(version));
+        std::stringstream old{old_version};
+        CHECK_THROWS_AS(contraction_hierarchy::load(old, map), const std::runtime_error &);
+
+        auto huge_count = saved;
+        const std::uint64_t count = std::uint64_t{1} << 40;
+        std::memcpy(huge_count.data() + forward_count_at, &count, sizeof(count));
+        std::stringstream huge{huge_count};
+        CHECK_THROWS_AS(contraction_hierarchy::load(huge, map), const std::runtime_error &);
+
+        const auto first_edge_at = header_size + offsets_size;
+        auto bad_target = saved;
+        const auto target = static_cast<contraction_hierarchy::index>(hierarchy.node_count());
+        std::memcpy(bad_target.data() + first_edge_at, &target, sizeof(target));
+        std::stringstream target_stream{bad_target};
+        CHECK_THROWS_AS(contraction_hierarchy::load(target_stream, map), const std::runtime_error &);
+
+        auto bad_weight = saved;
+        const unsigned weight = 0xffffffffu;
+        std::memcpy(bad_weight.data() + first_edge_at + sizeof(contraction_hierarchy::index), &weight, sizeof(weight));
+        std::stringstream weight_stream{bad_weight};
+        CHECK_THROWS_AS(contraction_hierarchy::load(weight_stream, map), const std::runtime_error &);
+    }
+    SECTION("rejects bad queries") {
+        CHECK_THROWS_AS(minimal_heat_loss(hierarchy, {.source = {0, 0}, .target = {20, 0}}), const std::out_of_range &);
+        CHECK_THROWS_AS(minimal_heat_loss(hierarchy, {.source = {0, 0}, .target = {3, 3}, .max_count = 10}),
+                        const std::invalid_argument &);
+    }
+}
@@ -0,0 +1,69 @@
+#include "aoc23.17.h"
+#include "aoc23.17.cost_to_go.h"
+#include "aoc23.17.generate.h"
+
+#include <sstream>
+
+#include "catch.hpp"
+
+TEST_CASE("cost to go table") {
+    const auto map = random_city_map(30, 25);
+    const auto depot = heat_loss_query::whole_map(map).target;
+    const auto table = cost_to_go_table::compute(map, depot);
+
+    SECTION("answers queries to its target by lookup") {
+        for (const auto source : {city_map::position{0, 0}, city_map::position{12, 7}, city_map::position{29, 3}}) {
+            CHECK(table.from(source) == minimal_heat_loss(map, {.source = source, .target = depot}));
+        }
+        CHECK(table.from(depot) == 0);
+    }
+    SECTION("guides the search to nearby targets") {
+        for (const auto target : {city_map::position{27, 22}, city_map::position{29, 20}, city_map::position{5, 5}}) {
+            const heat_loss_query query{.source = {3, 4}, .target = target};
+            CHECK(minimal_heat_loss(table, map, query) == minimal_heat_loss(map, query));
+        }
+    }
+    SECTION("rejects unsupported run lengths") {
+        CHECK_THROWS_AS(minimal_heat_loss(table, map, {.source = {0, 0}, .target = depot, .max_count = 10}),
+                        const std::invalid_argument &);
+        CHECK_THROWS_AS(minimal_heat_loss(table, map, {.source = {0, 0}, .target = {5, 5}, .max_count = 10}),
+                        const std::invalid_argument &);
+    }
+    SECTION("rejects sources outside of the map") {
+        CHECK_THROWS_AS(minimal_heat_loss(table, map, {.source = {30, 0}, .target = depot}), const std::out_of_range &);
+        CHECK_THROWS_AS(minimal_heat_loss(table, map, {.source = {0, 25}, .target = {5, 5}}),
+                        const std::out_of_range &);
+    }
+    SECTION("rejects queries on another map") {
+        const auto larger = random_city_map(40, 25);
+        CHECK_THROWS_AS(minimal_heat_loss(table, larger, {.source = {0, 0}, .target = {5, 5}}),
+                        const std::runtime_error &);
+        const auto taller = random_city_map(30, 30);
+        CHECK_THROWS_AS(minimal_heat_loss(table, taller, {.source = {0, 0}, .target = {5, 5}}),
+                        const std::runtime_error &);
+
+        auto other = map;
+        other.set_heat_loss({3, 3}, map.heat_loss({3, 3}) % 9 + 1);
+        CHECK_THROWS_AS(minimal_heat_loss(table, other, {.source = {0, 0}, .target = depot}),
+                        const std::runtime_error &);
+        CHECK_THROWS_AS(minimal_heat_loss(table, other, {.source = {0, 0}, .target = {5, 5}}),
+                        const std::runtime_error &);
+    }
+    SECTION("round trips through a stream") {
+        std::stringstream stream;
+        table.save(stream);
+        const auto loaded = cost_to_go_table::load(stream, map);
+        CHECK(loaded.target() == depot);
+        CHECK(loaded.from({12, 7}) == table.from({12, 7}));
+    }
+    SECTION("is only loaded for its map") {
+        std::stringstream stream;
+        table.save(stream);
+        auto other = map;
+        other.set_heat_loss({3, 3}, map.heat_loss({3, 3}) % 9 + 1);
+        CHECK_THROWS_AS(cost_to_go_table::load(stream, other), const std::runtime_error &);
+
+        std::stringstream truncated{stream.str().substr(0, 100)};
+        CHECK_THROWS_AS(cost_to_go_table::load(truncated, map), const std::runtime_error &);
+    }
+}
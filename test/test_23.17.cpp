@@ -1,5 +1,7 @@
 #include "aoc23.17.h"
+#include "aoc23.17.generate.h"
 
+#include "allocation_counter.h"
 #include "catch.hpp"
 
 TEST_CASE("city_map") {
@@ -10,6 +12,80 @@ TEST_CASE("city_map") {
     }
 }
 
+TEST_CASE("city_map segment costs") {
+    auto map = random_city_map(30, 20);
+    const auto sum_cells = [&](city_map::position pos, direction dir, std::size_t length) {
+        unsigned sum = 0;
+        for (std::size_t i = 0; i < length; ++i) {
+            if (dir == direction::NORTH) --pos.y;
+            if (dir == direction::SOUTH) ++pos.y;
+            if (dir == direction::WEST) --pos.x;
+            if (dir == direction::EAST) ++pos.x;
+            sum += map.heat_loss(pos);
+        }
+        return sum;
+    };
+    const auto check_all = [&] {
+        for (const auto &[pos, dir, length] : {std::tuple{city_map::position{0, 0}, direction::EAST, 29},
+                                                std::tuple{city_map::position{0, 0}, direction::SOUTH, 19},
+                                                std::tuple{city_map::position{29, 19}, direction::NORTH, 19},
+                                                std::tuple{city_map::position{29, 19}, direction::WEST, 29},
+                                                std::tuple{city_map::position{12, 7}, direction::EAST, 3},
+                                                std::tuple{city_map::position{12, 7}, direction::WEST, 1},
+                                                std::tuple{city_map::position{12, 7}, direction::NORTH, 7},
+                                                std::tuple{city_map::position{12, 7}, direction::SOUTH, 0}}) {
+            CHECK(map.segment_cost(pos, dir, length) == sum_cells(pos, dir, length));
+        }
+        CHECK_THROWS_AS(map.segment_cost({12, 7}, direction::NORTH, 8), const std::out_of_range &);
+        CHECK_THROWS_AS(map.segment_cost({12, 7}, direction::EAST, 18), const std::out_of_range &);
+        CHECK_THROWS_AS(map.segment_cost({30, 7}, direction::WEST, 1), const std::out_of_range &);
+    };
+
+    SECTION("without prefix sums") {
+        CHECK_FALSE(map.has_prefix_sums());
+        CHECK(map.prefix_sum_bytes() == 0);
+        check_all();
+    }
+    SECTION("16 bit prefix sums") {
+        map.build_prefix_sums();
+        CHECK(map.has_prefix_sums());
+        CHECK(map.prefix_sum_bytes() == (20 * 31 + 21 * 30) * sizeof(std::uint16_t));
+        check_all();
+    }
+    SECTION("32 bit prefix sums") {
+        map.set_heat_loss({3, 3}, 3000);
+        map.build_prefix_sums();
+        CHECK(map.prefix_sum_bytes() == (20 * 31 + 21 * 30) * sizeof(std::uint32_t));
+        check_all();
+    }
+    SECTION("dropped on changes") {
+        map.build_prefix_sums();
+        map.set_heat_loss({13, 7}, 1);
+        CHECK_FALSE(map.has_prefix_sums());
+        CHECK(map.segment_cost({12, 7}, direction::EAST, 1) == 1);
+    }
+}
+
+TEST_CASE("city_map_view") {
+    city_map map;
+    map.add_row({1, 2, 3, 4});
+    map.add_row({5, 6, 7, 8});
+
+    SECTION("reads the map without copying") {
+        const city_map_view view{map};
+        CHECK(view.width() == 4);
+        CHECK(view.height() == 2);
+        CHECK(view.heat_loss({2, 1}) == 7);
+        map.set_heat_loss({2, 1}, 9);
+        CHECK(view.heat_loss({2, 1}) == 9);
+    }
+    SECTION("window with stride") {
+        const city_map_view window{map.data() + 1, 2, 2, map.width()};
+        CHECK(window.heat_loss({0, 0}) == 2);
+        CHECK(window.heat_loss({1, 1}) == 7);
+    }
+}
+
 TEST_CASE("prio_queue") {
     prio_queue<char> queue;
     queue.add('A', 1);
@@ -42,6 +118,16 @@ TEST_CASE("prio_queue") {
         CHECK(queue.top().t == 'C');
         CHECK(queue.top().weight == 4);
     }
+    SECTION("adds below the top at the same weight") {
+        // the solvers pop the top only after adding its neighbours, which a cell without heat loss puts at its weight
+        queue.add('F', 1);
+        CHECK(queue.top().t == 'A');
+        queue.pop();
+        CHECK(queue.top().t == 'F');
+        CHECK(queue.top().weight == 1);
+        queue.pop();
+        CHECK(queue.top().t == 'B');
+    }
 }
 
 TEST_CASE("algorithm details") {
@@ -79,3 +165,212 @@ TEST_CASE("example case") {
     REQUIRE(minimal_heat_loss(map) == 102);
 }
 
+
+TEST_CASE("solver_stats") {
+    city_map map;
+    map.add_row({2,4,1,3,4});
+    map.add_row({3,2,1,5,4});
+    map.add_row({3,2,5,5,2});
+    map.add_row({3,4,4,6,5});
+
+    heat_loss_algorithm_dijkstra algorithm{map};
+    algorithm.run_dijkstra();
+    CHECK(algorithm.get_minimal_heat_loss() == 22);
+
+    const auto &stats = algorithm.stats;
+    CHECK(stats.to_json().starts_with(R"({"enabled": )"));
+    if constexpr (solver_stats::enabled) {
+        CHECK(stats.nodes_pushed == stats.nodes_popped);
+        CHECK(stats.max_queue_size > 0);
+        CHECK(stats.max_queue_size < stats.nodes_pushed);
+        CHECK(stats.relaxations >= stats.decreases);
+        CHECK(stats.decreases > 0);
+        CHECK(stats.peak_state_bytes > 0);
+    } else {
+        CHECK(stats.nodes_popped == 0);
+    }
+}
+
+TEST_CASE("staircase upper bound") {
+    SECTION("bounds the example from above") {
+        city_map map;
+        map.add_row({2,4,1,3,4});
+        map.add_row({3,2,1,5,4});
+        map.add_row({3,2,5,5,2});
+        map.add_row({3,4,4,6,5});
+        const auto bound = staircase_upper_bound(map, heat_loss_query::whole_map(map));
+        CHECK(bound >= 22);
+        CHECK(bound < heat_loss_algorithm::maximal_heat_loss);
+    }
+    SECTION("no monotone path") {
+        city_map map;
+        for (unsigned i = 0; i < 5; ++i) map.add_row({1});
+        CHECK(staircase_upper_bound(map, heat_loss_query::whole_map(map)) == heat_loss_algorithm::maximal_heat_loss);
+        CHECK(staircase_upper_bound(map, heat_loss_query{.source = {0, 4}, .target = {0, 2}}) == 2);
+    }
+    SECTION("pruning keeps the search exact") {
+        const auto map = random_city_map(30, 25);
+        const auto query = heat_loss_query{.source = {3, 20}, .target = {27, 2}};
+
+        heat_loss_algorithm_dijkstra exhaustive{map, query.source};
+        exhaustive.run_dijkstra();
+
+        heat_loss_algorithm_dijkstra pruned{map, query.source};
+        const auto bound = staircase_upper_bound(map, query);
+        pruned.prune_above(bound, query.target);
+        pruned.run_dijkstra();
+
+        const auto expected = exhaustive.get_minimal_heat_loss(query.target);
+        CHECK(bound >= expected);
+        CHECK(pruned.get_minimal_heat_loss(query.target) == expected);
+        CHECK(minimal_heat_loss(map, query) == expected);
+        if constexpr (solver_stats::enabled) {
+            CHECK(pruned.stats.upper_bound == bound);
+            CHECK(pruned.stats.pruned > 0);
+            CHECK(pruned.stats.nodes_pushed < exhaustive.stats.nodes_pushed);
+        }
+    }
+    SECTION("prunes a kept algorithm the same way") {
+        const auto map = random_city_map(30, 25);
+        const auto query = heat_loss_query{.source = {3, 20}, .target = {27, 2}};
+
+        heat_loss_algorithm_dijkstra kept{map, query.source};
+        CHECK(minimal_heat_loss(kept, query) == minimal_heat_loss(map, query));
+        if constexpr (solver_stats::enabled) {
+            CHECK(kept.stats.upper_bound == staircase_upper_bound(map, query));
+        }
+
+        kept.reset(map);
+        CHECK_THROWS_AS(minimal_heat_loss(kept, query), const std::invalid_argument &);
+    }
+}
+
+TEST_CASE("state graph search") {
+    using node = heat_loss_state_graph::node;
+    const auto map = random_city_map(30, 25);
+    const heat_loss_state_graph graph{map};
+    const auto query = heat_loss_query::whole_map(map);
+    const auto expected = minimal_heat_loss(map);
+
+    SECTION("forwards from the source") {
+        lazy_heat_loss_table heat_loss(graph.size());
+        auto search = make_state_graph_search(graph, heat_loss);
+        search.reach(heat_loss_state_graph::start_node(query.source), 0);
+        CHECK(search.run([&](const node &n, unsigned) { return n.pos == query.target; }) == expected);
+        CHECK_FALSE(search.empty());
+    }
+    SECTION("backwards from the target") {
+        std::vector<unsigned> values(graph.size(), heat_loss_algorithm::maximal_heat_loss);
+        heat_loss_span heat_loss{values};
+        auto search = make_state_graph_search(graph, heat_loss, search_direction::backward);
+        graph.for_each_node_at(query.target, [&](const node &n) { search.reach(n, 0); });
+        search.run();
+        CHECK(heat_loss.get(graph.to_index(heat_loss_state_graph::start_node(query.source))) == expected);
+    }
+    SECTION("with an estimate") {
+        lazy_heat_loss_table heat_loss(graph.size());
+        std::size_t settled = 0;
+        auto search = make_state_graph_search(graph, heat_loss, search_direction::forward, [&](const node &n) {
+            return static_cast<unsigned>(query.target.x - n.pos.x + query.target.y - n.pos.y);
+        });
+        search.reach(heat_loss_state_graph::start_node(query.source), 0);
+        CHECK(search.run([&](const node &n, unsigned) {
+            ++settled;
+            return n.pos == query.target;
+        }) == expected);
+        CHECK(settled < graph.size());
+    }
+    SECTION("confined to some states") {
+        lazy_heat_loss_table heat_loss(graph.size());
+        std::size_t outside = 0;
+        std::size_t left = 0;
+        auto search = make_state_graph_search(graph, heat_loss, search_direction::forward,
+                                              [](const node &) { return 0u; },
+                                              [](const node &n) { return n.pos.x < 10; });
+        search.reach(heat_loss_state_graph::start_node(query.source), 0);
+        search.run([&](const node &n, unsigned) { outside += n.pos.x >= 10; },
+                   [&](const node &n, unsigned) { left += n.pos.x == 10; });
+        CHECK(outside == 0);
+        CHECK(left > 0);
+        CHECK(heat_loss.get(graph.to_index(node{{10, 0}, {direction::EAST, 1}}))
+              == heat_loss_algorithm::maximal_heat_loss);
+    }
+}
+
+TEST_CASE("tiled state layout") {
+    const auto map = random_city_map(13, 7);
+    using layout = tiled_state_layout<4>;
+    CHECK(layout::cells(map) == 16 * 8);
+
+    std::vector<bool> used(layout::cells(map));
+    for (std::size_t y = 0; y < map.height(); ++y) {
+        for (std::size_t x = 0; x < map.width(); ++x) {
+            const auto i = layout::cell_index(map, {x, y});
+            REQUIRE(i < used.size());
+            CHECK(!used[i]);
+            used[i] = true;
+            CHECK((layout::cell_position(map, i) == city_map::position{x, y}));
+        }
+    }
+
+    const basic_heat_loss_state_graph<layout> graph{map};
+    const auto n = decltype(graph)::node{{12, 5}, {direction::WEST, 2}};
+    CHECK(graph.to_node(graph.to_index(n)) == n);
+}
+
+TEST_CASE("zeroed_buffer pages") {
+    CHECK(zeroed_buffer<unsigned>(100, page_mode::transparent_huge).obtained_pages() == page_mode::standard);
+
+    for (const auto pages : {page_mode::standard, page_mode::transparent_huge, page_mode::huge_tlb}) {
+        zeroed_buffer<unsigned> buffer(std::size_t{1} << 20, pages);
+        CHECK(buffer.obtained_pages() <= pages);
+        buffer[0] = 1;
+        buffer[buffer.size() - 1] = 2;
+        buffer.clear(buffer.size());
+        CHECK(buffer[0] == 0);
+        CHECK(buffer[buffer.size() - 1] == 0);
+    }
+
+    const auto map = random_city_map(30, 25);
+    heat_loss_algorithm_dijkstra algorithm{map, heat_loss_algorithm::initial_position, page_mode::transparent_huge};
+    algorithm.run_dijkstra();
+    CHECK(algorithm.get_minimal_heat_loss() == minimal_heat_loss(map));
+}
+
+TEST_CASE("query arena") {
+    const auto map = random_city_map(40, 30);
+    const auto query = heat_loss_query::whole_map(map);
+    heat_loss_algorithm_dijkstra algorithm{map};
+    const auto solve = [&] {
+        algorithm.reset(map);
+        algorithm.prune_above(staircase_upper_bound(map, query, &algorithm.arena), query.target);
+        algorithm.run_dijkstra();
+        return algorithm.get_minimal_heat_loss();
+    };
+
+    SECTION("steady state queries do not allocate") {
+        const auto expected = solve();
+        CHECK(solve() == expected);
+
+        const auto allocations_before = allocation_count();
+        const auto result = solve();
+        CHECK(allocation_count() == allocations_before);
+        CHECK(result == expected);
+        CHECK(result == minimal_heat_loss(map));
+    }
+    SECTION("merges outgrown blocks on reset") {
+        query_arena arena;
+        {
+            std::pmr::vector<int> values(&arena);
+            for (int i = 0; i < 1000; ++i) values.push_back(i);
+        }
+        const auto capacity = arena.capacity();
+        arena.reset();
+
+        const auto allocations_before = allocation_count();
+        std::pmr::vector<int> again(&arena);
+        again.reserve(1000);
+        CHECK(allocation_count() == allocations_before);
+        CHECK(arena.capacity() == capacity);
+    }
+}
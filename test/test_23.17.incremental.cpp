@@ -0,0 +1,73 @@
+#include "aoc23.17.h"
+#include "aoc23.17.generate.h"
+#include "aoc23.17.incremental.h"
+
+#include "catch.hpp"
+
+#include <random>
+
+TEST_CASE("incremental example case") {
+    city_map map;
+    map.add_row({2,4,1,3,4,3,2,3,1,1,3,2,3});
+    map.add_row({3,2,1,5,4,5,3,5,3,5,6,2,3});
+    map.add_row({3,2,5,5,2,4,5,6,5,4,2,5,4});
+    map.add_row({3,4,4,6,5,8,5,8,4,5,4,5,2});
+    map.add_row({4,5,4,6,6,5,7,8,6,7,5,3,6});
+    map.add_row({1,4,3,8,5,9,8,7,9,8,4,5,4});
+    map.add_row({4,4,5,7,8,7,6,9,8,7,7,6,6});
+    map.add_row({3,6,3,7,8,7,7,9,7,9,6,5,3});
+    map.add_row({4,6,5,4,9,6,7,9,8,6,8,8,7});
+    map.add_row({4,5,6,4,6,7,9,9,8,6,4,5,3});
+    map.add_row({1,2,2,4,6,8,6,8,6,5,5,6,3});
+    map.add_row({2,5,4,6,5,4,8,8,8,7,7,3,5});
+    map.add_row({4,3,2,2,6,7,4,6,5,5,5,3,3});
+
+    heat_loss_algorithm_incremental algorithm{map};
+    REQUIRE(algorithm.get_minimal_heat_loss() == 102);
+
+    SECTION("cheaper cells on the path") {
+        map.set_heat_loss({1, 0}, 1);
+        algorithm.set_heat_loss({1, 0}, 1);
+        CHECK(algorithm.get_minimal_heat_loss() == minimal_heat_loss(map));
+    }
+    SECTION("more expensive cells on the path") {
+        map.set_heat_loss({1, 0}, 9);
+        map.set_heat_loss({2, 0}, 9);
+        algorithm.set_heat_loss({1, 0}, 9);
+        algorithm.set_heat_loss({2, 0}, 9);
+        CHECK(algorithm.get_minimal_heat_loss() == minimal_heat_loss(map));
+    }
+    SECTION("restoring the original costs") {
+        algorithm.set_heat_loss({1, 0}, 9);
+        CHECK(algorithm.get_minimal_heat_loss() > 102);
+        algorithm.set_heat_loss({1, 0}, 4);
+        CHECK(algorithm.get_minimal_heat_loss() == 102);
+    }
+    SECTION("positions outside of the map") {
+        algorithm.set_heat_loss({1, 0}, 1);
+        map.set_heat_loss({1, 0}, 1);
+        CHECK_THROWS_AS(algorithm.set_heat_loss({13, 0}, 1), const std::out_of_range &);
+        CHECK_THROWS_AS(algorithm.set_heat_loss({0, 13}, 1), const std::out_of_range &);
+        CHECK(algorithm.get_minimal_heat_loss() == minimal_heat_loss(map));
+    }
+}
+
+TEST_CASE("incremental matches full re-solve") {
+    auto map = random_city_map(20, 15);
+    heat_loss_algorithm_incremental algorithm{map};
+
+    std::mt19937 engine{4711};
+    std::uniform_int_distribution<std::size_t> x{0, map.width()-1};
+    std::uniform_int_distribution<std::size_t> y{0, map.height()-1};
+    std::uniform_int_distribution<unsigned> digit{1, 9};
+
+    for (unsigned round = 0; round < 20; ++round) {
+        for (unsigned i = 0; i <= round % 4; ++i) {
+            const city_map::position pos{x(engine), y(engine)};
+            const auto value = digit(engine);
+            map.set_heat_loss(pos, value);
+            algorithm.set_heat_loss(pos, value);
+        }
+        REQUIRE(algorithm.get_minimal_heat_loss() == minimal_heat_loss(map));
+    }
+}
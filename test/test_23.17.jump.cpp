@@ -0,0 +1,61 @@
+#include "aoc23.17.h"
+#include "aoc23.17.alt.h"
+#include "aoc23.17.generate.h"
+#include "aoc23.17.jump.h"
+
+#include "catch.hpp"
+
+TEST_CASE("jump engine") {
+    SECTION("random map, many queries") {
+        const auto map = random_city_map(30, 25);
+        for (std::size_t i = 0; i < 40; ++i) {
+            const heat_loss_query query{.source = {i * 7 % 30, i * 3 % 25}, .target = {i * 11 % 30, i * 13 % 25}};
+            CHECK(minimal_heat_loss_jump(map, query) == minimal_heat_loss(map, query));
+        }
+        CHECK(minimal_heat_loss_jump(map, heat_loss_query::whole_map(map)) == minimal_heat_loss(map));
+    }
+    SECTION("uniform regions") {
+        const auto map = serpentine_city_map(40, 20);
+        CHECK(minimal_heat_loss_jump(map, heat_loss_query::whole_map(map)) == minimal_heat_loss(map));
+        const heat_loss_query query{.source = {39, 19}, .target = {0, 0}};
+        CHECK(minimal_heat_loss_jump(map, query) == minimal_heat_loss(map, query));
+    }
+    SECTION("cells without heat loss") {
+        auto map = random_city_map(20, 20);
+        for (std::size_t i = 0; i < 20; ++i) {
+            map.set_heat_loss({i, (i * 3) % 20}, 0);
+            map.set_heat_loss({(i * 7) % 20, i}, 0);
+        }
+        for (const auto &query : {heat_loss_query::whole_map(map), heat_loss_query{.source = {5, 5}, .target = {5, 5}},
+                                  heat_loss_query{.source = {0, 3}, .target = {0, 0}}}) {
+            CHECK(minimal_heat_loss_jump(map, query) == minimal_heat_loss(map, query));
+        }
+    }
+    SECTION("a single column") {
+        const auto map = random_city_map(1, 10);
+        // facing north at the start, going down needs a turn, which a single column does not have room for
+        const heat_loss_query down{.target = {0, 2}};
+        CHECK(minimal_heat_loss_jump(map, down) == minimal_heat_loss(map, down));
+        const heat_loss_query up{.source = {0, 9}, .target = {0, 7}};
+        CHECK(minimal_heat_loss_jump(map, up) == map.heat_loss({0, 8}) + map.heat_loss({0, 7}));
+        CHECK(minimal_heat_loss_jump(map, up) == minimal_heat_loss(map, up));
+    }
+    SECTION("fewer queue operations") {
+        const auto map = random_city_map(60, 60);
+        const auto query = heat_loss_query::whole_map(map);
+        heat_loss_algorithm_jump jump{map, query};
+        const auto blind = alt_search(alt_landmarks::compute(map, 0), query);
+        CHECK(jump.run() == blind.heat_loss);
+        CHECK(jump.expanded_nodes * 2 < blind.expanded_nodes);
+        if constexpr (solver_stats::enabled) {
+            CHECK(jump.stats.nodes_pushed == jump.pushed_nodes);
+            CHECK(jump.stats.nodes_popped == jump.expanded_nodes);
+        }
+    }
+    SECTION("checks the query") {
+        const auto map = random_city_map(5, 5);
+        CHECK_THROWS_AS(heat_loss_algorithm_jump(map, {.target = {5, 0}}), const std::out_of_range &);
+        CHECK_THROWS_AS(heat_loss_algorithm_jump(map, {.target = {4, 4}, .max_count = 10}),
+                        const std::invalid_argument &);
+    }
+}
@@ -0,0 +1,67 @@
+#include "aoc23.17.h"
+#include "aoc23.17.generate.h"
+#include "aoc23.17.overlay.h"
+
+#include "catch.hpp"
+
+TEST_CASE("tile overlay") {
+    // the tiles do not divide the map evenly
+    const auto map = random_city_map(30, 25);
+    const std::vector<heat_loss_query> queries{heat_loss_query::whole_map(map),
+                                               {.source = {20, 3}, .target = {4, 17}},
+                                               {.source = {7, 7}, .target = {8, 20}},
+                                               {.source = {1, 1}, .target = {5, 6}},
+                                               {.source = {29, 24}, .target = {0, 0}},
+                                               {.source = {12, 12}, .target = {12, 12}}};
+
+    SECTION("exact for any query") {
+        for (const std::size_t tile_size : {1, 4, 8, 30}) {
+            tile_overlay overlay{map, tile_size};
+            for (const auto &query : queries) {
+                CHECK(overlay.minimal_heat_loss(query) == minimal_heat_loss(map, query));
+            }
+        }
+    }
+    SECTION("exact on maps one cell wide") {
+        for (const auto &narrow : {random_city_map(10, 1), random_city_map(1, 10)}) {
+            tile_overlay overlay{narrow, 3};
+            const auto last = city_map::position{narrow.width() - 1, narrow.height() - 1};
+            CHECK(overlay.minimal_heat_loss({.source = {0, 0}, .target = last})
+                  == minimal_heat_loss(narrow, {.source = {0, 0}, .target = last}));
+            CHECK(overlay.minimal_heat_loss({.source = last, .target = {0, 0}})
+                  == minimal_heat_loss(narrow, {.source = last, .target = {0, 0}}));
+        }
+    }
+    SECTION("searches fewer overlay nodes than there are states") {
+        tile_overlay overlay{map, 8};
+        CHECK(overlay.tile_count() == 4 * 4);
+        CHECK(overlay.minimal_heat_loss(queries[0]) == minimal_heat_loss(map));
+        CHECK(overlay.settled_entries < overlay.entry_count());
+        CHECK(overlay.entry_count() < heat_loss_state_graph{map}.size() / 2);
+    }
+    SECTION("changed cells only recompute their tile") {
+        tile_overlay overlay{map, 8};
+        const auto initial_tiles = overlay.recomputed_tiles;
+        CHECK(initial_tiles == overlay.tile_count());
+
+        auto changed = map;
+        for (const auto pos : {city_map::position{9, 9}, city_map::position{14, 10}, city_map::position{3, 20}}) {
+            changed.set_heat_loss(pos, map.heat_loss(pos) % 9 + 1);
+            overlay.set_heat_loss(pos, map.heat_loss(pos) % 9 + 1);
+        }
+        // unchanged
+        overlay.set_heat_loss({0, 0}, map.heat_loss({0, 0}));
+        for (const auto &query : queries) {
+            CHECK(overlay.minimal_heat_loss(query) == minimal_heat_loss(changed, query));
+        }
+        CHECK(overlay.recomputed_tiles == initial_tiles + 2);
+    }
+    SECTION("rejects bad arguments") {
+        CHECK_THROWS_AS(tile_overlay(map, 0), const std::invalid_argument &);
+        tile_overlay overlay{map, 8};
+        CHECK_THROWS_AS(overlay.minimal_heat_loss({.source = {0, 0}, .target = {30, 0}}), const std::out_of_range &);
+        CHECK_THROWS_AS(overlay.minimal_heat_loss({.source = {0, 0}, .target = {3, 3}, .max_count = 10}),
+                        const std::invalid_argument &);
+        CHECK_THROWS_AS(overlay.set_heat_loss({0, 25}, 1), const std::out_of_range &);
+    }
+}
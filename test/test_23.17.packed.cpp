@@ -0,0 +1,47 @@
+#include "aoc23.17.h"
+#include "aoc23.17.generate.h"
+#include "aoc23.17.packed.h"
+
+#include "catch.hpp"
+
+TEST_CASE("packed city map") {
+    const auto map = random_city_map(71, 9);
+    packed_city_map packed{map};
+
+    SECTION("keeps every cell") {
+        CHECK(packed.width() == 71);
+        CHECK(packed.height() == 9);
+        CHECK(packed.memory_bytes() == 36 * 9);
+        for (std::size_t y = 0; y < map.height(); ++y) {
+            for (std::size_t x = 0; x < map.width(); ++x) {
+                REQUIRE(packed.heat_loss({x, y}) == map.heat_loss({x, y}));
+            }
+        }
+        CHECK(packed.unpack().content_hash() == map.content_hash());
+    }
+    SECTION("unpacks rows with either kernel") {
+        for (const std::size_t width : {1, 31, 32, 33, 64, 71}) {
+            const auto narrow = random_city_map(width, 3);
+            const packed_city_map narrow_packed{narrow};
+            for (const auto kernel : {relax_kernel::scalar, relax_kernel::avx2}) {
+                if (kernel == relax_kernel::avx2 && !avx2_available()) continue;
+                std::vector<unsigned> row(width + 1, 99);
+                narrow_packed.unpack_row(2, row.data(), kernel);
+                const auto end = row.begin() + static_cast<std::ptrdiff_t>(width);
+                CHECK(std::equal(row.begin(), end, narrow.data() + 2 * width));
+                // nothing written past the row
+                CHECK(row[width] == 99);
+            }
+        }
+    }
+    SECTION("changes single cells") {
+        packed.set_heat_loss({4, 3}, 15);
+        packed.set_heat_loss({5, 3}, 0);
+        CHECK(packed.heat_loss({4, 3}) == 15);
+        CHECK(packed.heat_loss({5, 3}) == 0);
+        CHECK(packed.heat_loss({3, 3}) == map.heat_loss({3, 3}));
+        CHECK(packed.heat_loss({6, 3}) == map.heat_loss({6, 3}));
+        CHECK_THROWS_AS(packed.set_heat_loss({4, 3}, 16), const std::invalid_argument &);
+        CHECK_THROWS_AS(packed.set_heat_loss({71, 3}, 1), const std::out_of_range &);
+    }
+}
@@ -0,0 +1,72 @@
+#include "aoc23.17.h"
+#include "aoc23.17.alt.h"
+#include "aoc23.17.generate.h"
+#include "aoc23.17.pyramid.h"
+
+#include "catch.hpp"
+
+TEST_CASE("cost pyramid") {
+    const auto map = random_city_map(30, 25);
+    const cost_pyramid pyramid{map};
+
+    SECTION("levels keep the cheapest cell of their block") {
+        REQUIRE(pyramid.level_count() == 6);
+        CHECK(pyramid.level_width(1) == 15);
+        CHECK(pyramid.level_height(1) == 13);
+        CHECK(pyramid.level_width(5) == 1);
+        CHECK(pyramid.level_height(5) == 1);
+        CHECK(pyramid.cheapest(0, {3, 4}) == map.heat_loss({3, 4}));
+        CHECK(pyramid.cheapest(1, {1, 2}) == std::min({map.heat_loss({2, 4}), map.heat_loss({3, 4}),
+                                                       map.heat_loss({2, 5}), map.heat_loss({3, 5})}));
+        // the odd last row stands alone
+        CHECK(pyramid.cheapest(1, {0, 12}) == std::min(map.heat_loss({0, 24}), map.heat_loss({1, 24})));
+        CHECK(pyramid.cheapest(5, {0, 0}) == 1);
+    }
+    SECTION("heuristic is a lower bound on every level") {
+        const city_map::position target{4, 17};
+        for (std::size_t level = 0; level < pyramid.level_count() + 1; ++level) {
+            const auto h = pyramid.heuristic_to(target, level);
+            CHECK(h(target) == 0);
+            for (const auto source : {city_map::position{20, 3}, city_map::position{29, 24},
+                                      city_map::position{4, 16}, city_map::position{0, 0}}) {
+                CHECK(h(source) <= minimal_heat_loss(map, {.source = source, .target = target}));
+            }
+        }
+    }
+    SECTION("exact for any query") {
+        for (const auto &query : {heat_loss_query::whole_map(map),
+                                  heat_loss_query{.source = {20, 3}, .target = {4, 17}},
+                                  heat_loss_query{.source = {7, 7}, .target = {7, 7}}}) {
+            CHECK(minimal_heat_loss(pyramid, query) == minimal_heat_loss(map, query));
+        }
+        CHECK_THROWS_AS(pyramid.heuristic_to({30, 0}), const std::out_of_range &);
+        CHECK_THROWS_AS(minimal_heat_loss(pyramid, {.target = {29, 24}, .max_count = 10}),
+                        const std::invalid_argument &);
+    }
+    SECTION("sees expensive regions") {
+        // cheap cells, cut in two by an expensive band with a gap at the right
+        city_map band;
+        for (std::size_t y = 0; y < 40; ++y) {
+            city_map::row row;
+            for (std::size_t x = 0; x < 40; ++x) {
+                row.push_back(x < 32 && y >= 16 && y < 24 ? 9 : 1);
+            }
+            band.add_row(row);
+        }
+        const cost_pyramid band_pyramid{band};
+        const heat_loss_query query{.source = {0, 0}, .target = {0, 39}};
+        heat_loss_algorithm_pyramid guided{band_pyramid, query};
+        CHECK(guided.run() == minimal_heat_loss(band, query));
+        const auto blind = alt_search(alt_landmarks::compute(band, 0), query);
+        CHECK(guided.expanded_nodes * 2 < blind.expanded_nodes);
+        heat_loss_algorithm_pyramid coarse{band_pyramid, query, 2};
+        CHECK(coarse.run() == blind.heat_loss);
+        CHECK(coarse.expanded_nodes * 2 < blind.expanded_nodes);
+        if constexpr (solver_stats::enabled) {
+            CHECK(guided.stats.heuristic_estimate > 0);
+            CHECK(guided.stats.heuristic_estimate <= blind.heat_loss);
+            CHECK(guided.stats.nodes_popped == guided.expanded_nodes);
+            CHECK(guided.stats.to_json().find(R"("heuristic_us": )") != std::string::npos);
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#include "aoc23.17.h"
+#include "aoc23.17.generate.h"
+#include "aoc23.17.relax.h"
+
+#include "catch.hpp"
+
+namespace {
+
+unsigned relax_to_fixpoint(city_map_view map, relax_kernel kernel) {
+    state_planes planes{map};
+    planes.set(heat_loss_state_graph::start_node(heat_loss_algorithm::initial_position), 0);
+    while (relax_pass(planes, kernel)) {}
+    return planes.minimum_at({map.width() - 1, map.height() - 1});
+}
+
+}
+
+TEST_CASE("relaxation kernels") {
+    // odd width, so that the vector kernel leaves a remainder to the scalar one
+    const auto map = random_city_map(37, 21);
+    const auto expected = minimal_heat_loss(map);
+
+    CHECK(relax_to_fixpoint(map, relax_kernel::scalar) == expected);
+    if (avx2_available()) {
+        CHECK(relax_to_fixpoint(map, relax_kernel::avx2) == expected);
+    }
+}
+
+TEST_CASE("relax_row carries runs both ways") {
+    const auto map = random_city_map(12, 1);
+    for (const auto dir : {direction::EAST, direction::WEST}) {
+        state_planes planes{map};
+        const auto east = dir == direction::EAST;
+        planes.set(heat_loss_state_graph::node{{east ? 0u : 11u, 0}, {dir, 1}}, 0);
+        CHECK(relax_row(planes, 0, relax_kernel::scalar));
+        const city_map::position third{east ? 2u : 9u, 0};
+        CHECK(planes.get(heat_loss_state_graph::node{third, {dir, 3}})
+              == map.heat_loss({east ? 1u : 10u, 0}) + map.heat_loss(third));
+    }
+}
+
+TEST_CASE("relax_pass reports changes") {
+    const auto map = random_city_map(12, 9);
+    state_planes planes{map};
+    CHECK_FALSE(relax_pass(planes));
+
+    planes.set(heat_loss_state_graph::start_node(heat_loss_algorithm::initial_position), 0);
+    CHECK(relax_pass(planes));
+    CHECK(planes.get(heat_loss_state_graph::node{{1, 0}, {direction::EAST, 1}}) == map.heat_loss({1, 0}));
+    CHECK(planes.get(heat_loss_state_graph::node{{0, 1}, {direction::SOUTH, 1}})
+          == heat_loss_algorithm::maximal_heat_loss);
+}
@@ -0,0 +1,138 @@
+#include "aoc23.17.h"
+#include "allocation_counter.h"
+#include "aoc23.17.generate.h"
+
+#include "catch.hpp"
+
+#if AOC_SERVER
+#include "aoc23.17.server.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <thread>
+
+TEST_CASE("solver_protocol decodes maps") {
+    using namespace solver_protocol;
+    const auto map = random_city_map(7, 5);
+
+    for (const auto format : {map_format::text, map_format::binary}) {
+        const auto request = encode_request(3, map, heat_loss_query::whole_map(map), format);
+        request_header header;
+        std::memcpy(&header, request.data(), sizeof(header));
+        CHECK(header.id == 3);
+        const auto decoded = decode_map(header, std::string_view{request}.substr(sizeof(header)));
+        CHECK(decoded.content_hash() == map.content_hash());
+    }
+
+    request_header header{.format = map_format::text, .width = 3, .height = 1};
+    CHECK_THROWS(decode_map(header, "12x\n"));
+    CHECK_THROWS(decode_map(header, "1234\n"));
+
+    // a header promising a huge map is refused before the server allocates a row for it
+    for (const auto format : {map_format::text, map_format::binary}) {
+        const request_header huge{.format = format, .width = 0xffffffffu, .height = 1, .payload_size = 4};
+        CHECK_THROWS_AS(decode_map(huge, "123\n"), const std::invalid_argument &);
+        const request_header tall{.format = format, .width = 2, .height = 0xffffffffu, .payload_size = 4};
+        CHECK_THROWS_AS(decode_map(tall, "12\n\n"), const std::invalid_argument &);
+    }
+}
+
+TEST_CASE("solver_server answers pipelined queries") {
+    using namespace solver_protocol;
+    const auto socket_path = std::format("/tmp/aoc_23_test_{}.sock", ::getpid());
+    solver_server server{socket_path, 2};
+    std::thread serving([&server] { server.run(); });
+
+    const int fd = connect_to(socket_path);
+    std::map<std::uint32_t, unsigned> expected;
+    for (std::uint32_t id = 0; id < 6; ++id) {
+        const auto map = random_city_map(10 + id, 8, id);
+        auto query = heat_loss_query::whole_map(map);
+        if (id % 3 == 2) {
+            query.source = {2, 3};
+            query.target = {5, 1};
+        }
+        expected[id] = minimal_heat_loss(map, query);
+        const auto request = encode_request(id, map, query, id % 2 ? map_format::text : map_format::binary);
+        REQUIRE(write_all(fd, request.data(), request.size()));
+    }
+    const request_header invalid{.id = 99, .width = 4, .height = 4, .payload_size = 3};
+    REQUIRE(write_all(fd, &invalid, sizeof(invalid)));
+    REQUIRE(write_all(fd, "123", 3));
+
+    for (std::size_t i = 0; i <= expected.size(); ++i) {
+        response_header response;
+        REQUIRE(read_all(fd, &response, sizeof(response)));
+        if (response.id == 99) {
+            CHECK(response.result == status::invalid_request);
+        } else {
+            CHECK(response.result == status::ok);
+            CHECK(response.heat_loss == expected.at(response.id));
+        }
+    }
+    ::close(fd);
+
+    server.stop();
+    serving.join();
+    CHECK(server.answered() == expected.size() + 1);
+}
+
+TEST_CASE("solver_server refuses oversized payloads before reading them") {
+    using namespace solver_protocol;
+    const auto socket_path = std::format("/tmp/aoc_23_test_oversized_{}.sock", ::getpid());
+    solver_server server{socket_path, 1};
+    std::thread serving([&server] { server.run(); });
+
+    const auto bytes_before = allocated_bytes();
+    {
+        // far more than a 4x4 map can take
+        const int fd = connect_to(socket_path);
+        const request_header oversized{.id = 7, .width = 4, .height = 4, .payload_size = max_payload_size};
+        REQUIRE(write_all(fd, &oversized, sizeof(oversized)));
+        response_header response;
+        REQUIRE(read_all(fd, &response, sizeof(response)));
+        CHECK(response.id == 7);
+        CHECK(response.result == status::invalid_request);
+        ::close(fd);
+    }
+    {
+        // a huge map whose payload never comes
+        const int fd = connect_to(socket_path);
+        const request_header huge{.id = 8, .width = 1u << 14, .height = 1u << 14, .payload_size = 1u << 28};
+        REQUIRE(write_all(fd, &huge, sizeof(huge)));
+        REQUIRE(write_all(fd, "123", 3));
+        ::shutdown(fd, SHUT_WR);
+        response_header response;
+        CHECK_FALSE(read_all(fd, &response, sizeof(response)));
+        ::close(fd);
+    }
+    CHECK(allocated_bytes() - bytes_before < std::size_t{1} << 20);
+
+    server.stop();
+    serving.join();
+    CHECK(server.answered() == 0);
+}
+
+TEST_CASE("solver_server releases closed connections while idle") {
+    using namespace solver_protocol;
+    const auto socket_path = std::format("/tmp/aoc_23_test_idle_{}.sock", ::getpid());
+    solver_server server{socket_path, 1};
+    std::thread serving([&server] { server.run(); });
+
+    for (unsigned i = 0; i < 3; ++i) {
+        ::close(connect_to(socket_path));
+    }
+    // no further connection is accepted, the readers have to go on their own
+    for (unsigned attempt = 0; attempt < 500 && server.open_connections() > 0; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(server.open_connections() == 0);
+
+    server.stop();
+    serving.join();
+}
+#endif
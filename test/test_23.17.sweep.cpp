@@ -0,0 +1,44 @@
+#include "aoc23.17.h"
+#include "aoc23.17.generate.h"
+#include "aoc23.17.sweep.h"
+
+#include "catch.hpp"
+
+TEST_CASE("sweep engine") {
+    SECTION("random map") {
+        const auto map = random_city_map(30, 25);
+        heat_loss_algorithm_sweep algorithm{map};
+        CHECK(algorithm.run());
+        CHECK(algorithm.get_minimal_heat_loss() == minimal_heat_loss(map));
+    }
+    SECTION("serpentine map") {
+        const auto map = serpentine_city_map(40, 20);
+        for (const auto kernel : {relax_kernel::scalar, relax_kernel::avx2}) {
+            if (kernel == relax_kernel::avx2 && !avx2_available()) continue;
+            heat_loss_algorithm_sweep algorithm{map, heat_loss_algorithm::initial_position, kernel};
+            CHECK(algorithm.run());
+            CHECK(algorithm.get_minimal_heat_loss() == minimal_heat_loss(map));
+        }
+    }
+    SECTION("other source and target") {
+        const auto map = random_city_map(30, 25);
+        const heat_loss_query query{.source = {20, 3}, .target = {4, 17}};
+        CHECK(minimal_heat_loss_sweep(map, query) == minimal_heat_loss(map, query));
+        CHECK_THROWS_AS(minimal_heat_loss_sweep(map, {.source = {20, 3}, .target = {4, 25}}),
+                        const std::out_of_range &);
+        CHECK_THROWS_AS(minimal_heat_loss_sweep(map, {.source = {20, 3}, .target = {4, 17}, .max_count = 10}),
+                        const std::invalid_argument &);
+    }
+    SECTION("sweep cap") {
+        const auto map = serpentine_city_map(40, 20);
+        const auto exact = minimal_heat_loss(map);
+        heat_loss_algorithm_sweep algorithm{map};
+        CHECK_FALSE(algorithm.run(2));
+        CHECK(algorithm.sweeps == 2);
+        CHECK(algorithm.get_minimal_heat_loss() >= exact);
+
+        CHECK(algorithm.run());
+        CHECK(algorithm.sweeps > 2);
+        CHECK(algorithm.get_minimal_heat_loss() == exact);
+    }
+}
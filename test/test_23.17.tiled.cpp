@@ -0,0 +1,55 @@
+#include "aoc23.17.h"
+#include "aoc23.17.generate.h"
+#include "aoc23.17.jump.h"
+#include "aoc23.17.packed.h"
+#include "aoc23.17.tiled.h"
+
+#include "catch.hpp"
+
+static_assert(heat_loss_map<city_map>);
+static_assert(heat_loss_map<city_map_view>);
+static_assert(heat_loss_map<packed_city_map>);
+static_assert(heat_loss_map<tiled_city_map<>>);
+
+TEST_CASE("tiled city map") {
+    const auto base = random_city_map(7, 5);
+    const tiled_city_map tiled{base, 3, 2};
+
+    SECTION("repeats the base map with an increment per tile") {
+        CHECK(tiled.width() == 21);
+        CHECK(tiled.height() == 10);
+        CHECK(tiled.heat_loss({3, 2}) == base.heat_loss({3, 2}));
+        CHECK(tiled.heat_loss({10, 2}) == wrapping_tile_increment{}(base.heat_loss({3, 2}), 1, 0));
+        CHECK(tiled.heat_loss({17, 7}) == wrapping_tile_increment{}(base.heat_loss({3, 2}), 2, 1));
+        CHECK(wrapping_tile_increment{}(9, 1, 0) == 1);
+        CHECK(wrapping_tile_increment{}(8, 2, 1) == 2);
+        CHECK(wrapping_tile_increment{}(0, 0, 0) == 0);
+    }
+    SECTION("solvers read it without materializing it") {
+        const auto materialized = to_city_map(tiled);
+        CHECK(materialized.width() == 21);
+        for (const auto &query : {heat_loss_query::whole_map(tiled),
+                                  heat_loss_query{.source = {20, 9}, .target = {2, 1}}}) {
+            CHECK(minimal_heat_loss(tiled, query) == minimal_heat_loss(materialized, query));
+        }
+        CHECK(minimal_heat_loss(tiled) == minimal_heat_loss(materialized));
+
+        const basic_heat_loss_state_graph<row_major_state_layout, tiled_city_map<>> graph{tiled};
+        CHECK(graph.size() == 21 * 10 * heat_loss_state_graph::states_per_cell);
+        std::size_t successors = 0;
+        graph.for_each_successor(graph.start_node({20, 9}), [&](const auto &) { ++successors; });
+        CHECK(successors == 2);
+    }
+    SECTION("any transform") {
+        const tiled_city_map mirrored{base, 2, 2, [](unsigned heat_loss, std::size_t tile_x, std::size_t tile_y) {
+            return (tile_x + tile_y) % 2 == 0 ? heat_loss : 10 - heat_loss;
+        }};
+        CHECK(mirrored.heat_loss({8, 0}) == 10 - base.heat_loss({1, 0}));
+        CHECK(mirrored.heat_loss({8, 6}) == base.heat_loss({1, 1}));
+        CHECK(minimal_heat_loss(mirrored) == minimal_heat_loss(to_city_map(mirrored)));
+    }
+    SECTION("packed maps too") {
+        const packed_city_map packed{base};
+        CHECK(minimal_heat_loss(packed) == minimal_heat_loss(base));
+    }
+}
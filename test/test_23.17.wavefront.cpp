@@ -0,0 +1,58 @@
+#include "aoc23.17.h"
+#include "aoc23.17.generate.h"
+#include "aoc23.17.sweep.h"
+#include "aoc23.17.wavefront.h"
+
+#include "catch.hpp"
+
+TEST_CASE("wavefront engine") {
+    SECTION("random map, any number of threads and tiles") {
+        const auto map = random_city_map(30, 25);
+        const auto exact = minimal_heat_loss(map);
+        for (const unsigned threads : {1, 2, 4}) {
+            for (const std::size_t tile_size : {1, 4, 32}) {
+                heat_loss_algorithm_wavefront algorithm{map, heat_loss_algorithm::initial_position, threads, tile_size};
+                CHECK(algorithm.run());
+                CHECK(algorithm.get_minimal_heat_loss() == exact);
+            }
+        }
+    }
+    SECTION("serpentine map") {
+        const auto map = serpentine_city_map(40, 20);
+        CHECK(minimal_heat_loss_wavefront(map, heat_loss_query::whole_map(map), 3) == minimal_heat_loss(map));
+    }
+    SECTION("west heading serpentine") {
+        // walls too expensive to cross, from the top right corner the cheapest path starts westwards
+        const auto map = serpentine_city_map(40, 20, 1, 1000);
+        const city_map::position source{39, 0};
+        for (const auto kernel : {relax_kernel::scalar, best_relax_kernel()}) {
+            heat_loss_algorithm_sweep sweep{map, source, kernel};
+            REQUIRE(sweep.run());
+            heat_loss_algorithm_wavefront wavefront{map, source, 1, 64, kernel};
+            REQUIRE(wavefront.run());
+            CHECK(wavefront.get_minimal_heat_loss() == sweep.get_minimal_heat_loss());
+            CHECK(wavefront.sweeps < sweep.sweeps);
+        }
+    }
+    SECTION("other source and target") {
+        const auto map = random_city_map(30, 25);
+        const heat_loss_query query{.source = {20, 3}, .target = {4, 17}};
+        CHECK(minimal_heat_loss_wavefront(map, query, 2) == minimal_heat_loss(map, query));
+        CHECK_THROWS_AS(minimal_heat_loss_wavefront(map, {.source = {20, 3}, .target = {30, 17}}, 2),
+                        const std::out_of_range &);
+        CHECK_THROWS_AS(minimal_heat_loss_wavefront(map, {.source = {20, 3}, .target = {4, 17}, .max_count = 10}, 2),
+                        const std::invalid_argument &);
+    }
+    SECTION("sweep cap") {
+        const auto map = serpentine_city_map(40, 20);
+        const auto exact = minimal_heat_loss(map);
+        heat_loss_algorithm_wavefront algorithm{map, heat_loss_algorithm::initial_position, 2, 8};
+        CHECK_FALSE(algorithm.run(2));
+        CHECK(algorithm.sweeps == 2);
+        CHECK(algorithm.get_minimal_heat_loss() >= exact);
+
+        CHECK(algorithm.run());
+        CHECK(algorithm.sweeps > 2);
+        CHECK(algorithm.get_minimal_heat_loss() == exact);
+    }
+}